@@ -1,163 +1,586 @@
 #include "Algorithm.hpp"
 
 #include <algorithm>
-#include <iterator>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+#include "PlacementCheck.hpp"
+#include "RadixSort.hpp"
 
 namespace algo {
     std::unique_ptr<Algorithm> createDefaultAlgorithm() {
         return std::make_unique<GridBasedAlgorithm>();
     }
 
+    GridBasedAlgorithm::GridBasedAlgorithm(const AlgorithmSettings& settings) :
+        settings{ settings }, arena{ settings.solve_memory_limit } {}
+
     std::optional<objects::ResultData> GridBasedAlgorithm::calculate(const objects::Scene& scene) {
+        return calculate(objects::SceneView(scene));
+    }
+
+    std::optional<objects::ResultData> GridBasedAlgorithm::calculate(const objects::SceneView& scene) {
+        objects::ResultData result;
+        if (!calculate(scene, result))
+            return std::nullopt;
+        return result;
+    }
+
+    std::optional<objects::ResultData> GridBasedAlgorithm::calculate(const objects::SceneView& scene, AlgorithmStats& out_stats) {
+        auto result = calculate(scene);
+        out_stats = stats;
+        return result;
+    }
+
+    bool GridBasedAlgorithm::calculate(const objects::SceneView& scene, objects::ResultData& result) {
+        return run(scene, result, nullptr) == SolveStatus::SOLVED;
+    }
+
+    bool GridBasedAlgorithm::calculate(const objects::SceneView& scene, objects::ResultData& result, AlgorithmStats& out_stats) {
+        bool success = calculate(scene, result);
+        out_stats = stats;
+        return success;
+    }
+
+    SolveStatus GridBasedAlgorithm::calculate(const objects::SceneView& scene, objects::ResultData& result, const CancellationToken& stop_token) {
+        return run(scene, result, &stop_token);
+    }
+
+    SolveStatus GridBasedAlgorithm::run(const objects::SceneView& scene, objects::ResultData& result, const CancellationToken* stop_token) {
+        token = stop_token;
+        SolveStatus status = solve(scene, result);
+        token = nullptr;
+        releaseSolveMemory();
+        return status;
+    }
+
+    SolveStatus GridBasedAlgorithm::solve(const objects::SceneView& scene, objects::ResultData& result) {
+        stats = {};
+        result.circles.clear();
         initGrid(scene.getZone(), scene.getExclusionAreas());
+        if (stopRequested())
+            return stopStatus();
 
-        auto layouts = grid->calculateAllowedAreas(GridCalculationMode::HORIZONTAL, LayoutAlignment::WIDTH_LESS);
+        auto& circles = scene.getCircles();
+        if (circles.empty())
+            return SolveStatus::SOLVED;
 
-        bool success = fillLayouts(layouts, scene.getCircles());
-        if (!success)
-            return std::nullopt;
+        // Layouts narrower than the smallest inner diameter can't hold any circle
+        objects::Scalar min_rad = *std::min_element(circles.getInRads().begin(), circles.getInRads().end());
 
-        relaxCircleDistribution(layouts);
+        AreaLayouts layouts(arena.resource());
+        {
+            ALGO_STATS_TIMER(stats, allowed_areas_ms);
+            layouts = grid->calculateAllowedAreas(settings.grid_mode, settings.alignment, min_rad * 2, min_rad * 2);
+        }
+        ALGO_STATS_SET(stats, allowed_layouts, layouts.size());
+        if (stopRequested())
+            return stopStatus();
+
+        placed_circles.reserve(circles.size());
+        SolveStatus status = fillLayouts(layouts, circles);
+        if (status == SolveStatus::FAILED)
+            return status;
+
+        // A stopped solve keeps the circles where they were placed
+        if (status == SolveStatus::SOLVED)
+            relaxCircleDistribution(layouts, circles);
         recalculateCirclesPositions(layouts);
 
-        std::vector<objects::PositionedCircle> results;
-        for (auto& l : layouts) {
-            std::move(l.circles.begin(), l.circles.end(), std::back_inserter(results));
-        }
-        return objects::ResultData{ results };
+        result.circles.reserve(placed_circles.size());
+        for (auto& c : placed_circles)
+            result.circles.push_back({ circles[c.circle], c.position });
+        if (status == SolveStatus::SOLVED && settings.verify_results && !verifyResults(scene, result))
+            return SolveStatus::FAILED;
+        return status;
     }
 
-    void GridBasedAlgorithm::initGrid(const objects::Rectangle& zone, const std::vector<objects::Rectangle>& exclusion_areas) {
-        grid = std::make_unique<AreasGrid>(zone, exclusion_areas);
+    bool GridBasedAlgorithm::verifyResults(const objects::SceneView& scene, const objects::ResultData& result) {
+        ALGO_STATS_TIMER(stats, verify_results_ms);
+        // Rounding moves the positions by a part of the biggest coordinate, however small the zone is
+        auto& zone = scene.getZone();
+        double max_coord = std::max({ std::abs(zone.minPoint().x), std::abs(zone.maxPoint().x),
+            std::abs(zone.minPoint().y), std::abs(zone.maxPoint().y) });
+        double tolerance = settings.verify_tolerance * max_coord * std::numeric_limits<objects::Scalar>::epsilon();
+        size_t violations = countPlacementViolations(scene, result, tolerance, arena.resource());
+        ALGO_STATS_SET(stats, placement_violations, violations);
+        return violations == 0;
     }
 
-    bool GridBasedAlgorithm::fillLayouts(std::vector<AreaLayout>& layouts, std::vector<objects::Circle> circles) {
-        std::sort(layouts.begin(), layouts.end(), [](auto& a, auto& b) {return a.width > b.width; });
-        std::sort(circles.begin(), circles.end(), [](auto& a, auto& b) {return a.outRad() > b.outRad(); });
+    void GridBasedAlgorithm::releaseSolveMemory() {
+        // Everything allocated from the arena has to be gone before its memory is reused
+        grid.reset();
+        std::pmr::vector<PlacedCircle>(arena.resource()).swap(placed_circles);
+        arena.release();
+        for (auto& a : region_algorithms)
+            a->releaseSolveMemory();
+    }
 
-        double min_rad = circles.back().inRad();
-        for (auto& c : circles)
-            min_rad = std::min(min_rad, c.inRad());
+    void GridBasedAlgorithm::initGrid(const objects::Rectangle& zone, objects::ArrayView<objects::Rectangle> exclusion_areas) {
+        ALGO_STATS_TIMER(stats, init_grid_ms);
+        grid.emplace(zone, exclusion_areas, settings.grid_threads,
+            settings.grid_memory_budget, settings.snap_epsilon, arena.resource(), token);
+    }
 
-        auto discard_it = std::upper_bound(layouts.begin(), layouts.end(), min_rad * 2,
-            [](double min_width, auto el) {
-                return min_width > el.width;
-            });
-        if (discard_it < layouts.end())
-            layouts.erase(discard_it, layouts.end());
+    SolveStatus GridBasedAlgorithm::fillLayouts(AreaLayouts& layouts, const objects::CirclesView& circles) {
+        ALGO_STATS_TIMER(stats, fill_layouts_ms);
+
+        // Circles are placed by decreasing outer radius, only the radiuses arrays are read to order them
+        auto out_rads = circles.getOutRads();
+        auto order = radixOrderDescending(out_rads, arena.resource());
+
+        size_t regions = (circles.size() >= parallel_placement_circles) ? std::min(settings.placement_threads, layouts.size()) : 1;
+        if (regions > 1)
+            return fillRegions(layouts, circles, order, regions);
+        sortLayouts(layouts);
+        return placeCircles(layouts, circles, order, nullptr);
+    }
+
+    SolveStatus GridBasedAlgorithm::placeCircles(AreaLayouts& layouts, const objects::CirclesView& circles,
+        const std::pmr::vector<size_t>& order, std::pmr::vector<size_t>* unplaced) {
+        auto out_rads = circles.getOutRads();
+        auto in_rads = circles.getInRads();
+
+        // Minimal inner radius of the circles which are not placed yet
+        std::pmr::vector<objects::Scalar> min_rads(order.size(), arena.resource());
+        for (size_t i = order.size(); i-- > 0; )
+            min_rads[i] = (i + 1 < order.size()) ? std::min(in_rads[order[i]], min_rads[i + 1]) : in_rads[order[i]];
+
+        // Layouts left narrower and lower than the smallest circle are retired by the index on their update
+        LayoutIndex index(layouts.spaces, layouts.sides, arena.resource());
+        auto updateIndex = [&index, &layouts](size_t layout_ind) {
+            size_t pos = index.position(layout_ind);
+            if (pos < index.size() && index.layout(pos) == layout_ind)
+                index.update(pos, layouts.spaces[layout_ind], layouts.sides[layout_ind]);
+        };
 
         size_t traversal_ind = 0;
-        for (auto& c : circles) {
-            if (!placeCircle(layouts, c, traversal_ind))
-                return false;
+        size_t run_end = 0;
+        size_t steps = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (steps++ % stop_check_period == 0 && stopRequested())
+                return stopStatus();
+            index.setMinInRad(min_rads[i]);
+            size_t layouts_count = layouts.size();
+            auto circle = circles[order[i]];
+            if (!placeCircle(layouts, index, order[i], circle, traversal_ind)) {
+                if (!unplaced)
+                    return SolveStatus::FAILED;
+                unplaced->push_back(order[i]);
+                continue;
+            }
 
-            auto& last_layout = layouts[traversal_ind];
-            if (last_layout.width - last_layout.filled_width < min_rad &&
-                last_layout.height - last_layout.filled_height < min_rad)
-                last_layout.filled = true;
+            // Best fit keeps choosing the layout which got the circle while the following equal circles fit in it,
+            // so they are stacked there at once. Round-robin spreads them between layouts and places them one by one.
+            if (settings.selection == LayoutSelection::BEST_FIT) {
+                if (run_end <= i) {
+                    for (run_end = i + 1; run_end < order.size() &&
+                        in_rads[order[run_end]] == circle.inRad() && out_rads[order[run_end]] == circle.outRad(); )
+                        ++run_end;
+                }
+                size_t run_layout = (layouts.size() > layouts_count) ? layouts.size() - 1 : traversal_ind;
+                size_t placed = placeRun(layouts, run_layout, circles, order, i + 1, run_end);
+                if (placed > 0) {
+                    updateIndex(run_layout);
+                    traversal_ind = run_layout;
+                    i += placed;
+                }
+            }
 
             traversal_ind++;
         }
-        return true;
+        return SolveStatus::SOLVED;
     }
 
-    bool GridBasedAlgorithm::placeCircle(std::vector<AreaLayout>& layouts, objects::Circle& circle, size_t& start) {
-        for (size_t j = 0; j < layouts.size(); ++j) {
-            size_t i = (start + j) % layouts.size();
-            auto& cur_layout = layouts[i];
+    SolveStatus GridBasedAlgorithm::fillRegions(AreaLayouts& layouts, const objects::CirclesView& circles,
+        const std::pmr::vector<size_t>& order, size_t regions) {
+        while (region_algorithms.size() + 1 < regions) {
+            AlgorithmSettings region_settings = settings;
+            region_settings.placement_threads = 1;
+            region_algorithms.push_back(std::make_unique<GridBasedAlgorithm>(region_settings));
+        }
+        // The first region is filled by this algorithm, every region uses the memory of its algorithm
+        auto regionAlgorithm = [this](size_t r) -> GridBasedAlgorithm& { return r ? *region_algorithms[r - 1] : *this; };
 
-            if (!cur_layout.filled) {
-                auto x_pos = findMinWidth(cur_layout, circle.inRad(), circle.outRad());
-                auto y_pos = findMinHeight(cur_layout, circle.inRad(), circle.outRad());
+        // Layouts are ordered by their position in the zone and cut into bands of about equal free area
+        std::pmr::vector<size_t> spatial(layouts.size(), arena.resource());
+        std::iota(spatial.begin(), spatial.end(), size_t{ 0 });
+        std::sort(spatial.begin(), spatial.end(), [&layouts](size_t a, size_t b) {
+            auto& pa = layouts.areas[a].min_point;
+            auto& pb = layouts.areas[b].min_point;
+            return pa.y < pb.y || (pa.y == pb.y && pa.x < pb.x); });
+        double total_area = 0.0;
+        for (auto& s : layouts.spaces)
+            total_area += static_cast<double>(s.width) * s.height;
 
-                if (x_pos && y_pos) {
-                    cur_layout.circles.push_back({ circle, {x_pos.value(), y_pos.value()} });
-                    cur_layout.filled_height = y_pos.value() + circle.outRad();
-                    cur_layout.filled_width = std::max(cur_layout.filled_width, x_pos.value() + circle.outRad());
-                    start = i;
-                    return true;
-                }
+        std::vector<AreaLayouts> region_layouts;
+        std::vector<std::pmr::vector<size_t>> region_orders, region_unplaced;
+        std::pmr::vector<double> region_areas(regions, 0.0, arena.resource());
+        for (size_t r = 0; r < regions; ++r) {
+            auto resource = regionAlgorithm(r).arena.resource();
+            region_layouts.emplace_back(resource);
+            region_orders.emplace_back(resource);
+            region_unplaced.emplace_back(resource);
+        }
+        double area = 0.0;
+        for (auto l : spatial) {
+            auto& space = layouts.spaces[l];
+            size_t r = std::min(static_cast<size_t>(area / total_area * regions), regions - 1);
+            area += static_cast<double>(space.width) * space.height;
+            region_areas[r] += static_cast<double>(space.width) * space.height;
+            region_layouts[r].push_back(space, layouts.sides[l], layouts.areas[l]);
+        }
+
+        // Every circle goes to the region filled the least relative to its area, so the regions get
+        // the circles squares in proportion to their areas and a share of every circle size
+        std::pmr::vector<double> region_filled(regions, 0.0, arena.resource());
+        for (auto c : order) {
+            size_t best = regions;
+            for (size_t r = 0; r < regions; ++r) {
+                if (region_areas[r] > 0 && (best == regions ||
+                    region_filled[r] * region_areas[best] < region_filled[best] * region_areas[r]))
+                    best = r;
+            }
+            double side = circles.outRad(c) * 2.0;
+            region_filled[best] += side * side;
+            region_orders[best].push_back(c);
+        }
+
+        std::vector<SolveStatus> statuses(regions, SolveStatus::SOLVED);
+        std::vector<std::exception_ptr> errors(regions);
+        auto fill = [&](size_t r) {
+            auto& algorithm = regionAlgorithm(r);
+            try {
+                algorithm.sortLayouts(region_layouts[r]);
+                algorithm.placed_circles.reserve(region_orders[r].size());
+                statuses[r] = algorithm.placeCircles(region_layouts[r], circles, region_orders[r], &region_unplaced[r]);
+            } catch (...) {
+                errors[r] = std::current_exception();
+            }
+        };
+        for (size_t r = 1; r < regions; ++r) {
+            regionAlgorithm(r).token = token;
+            regionAlgorithm(r).stats = {};
+        }
+        auto joinWorkers = [&](std::vector<std::thread>& workers) {
+            for (auto& w : workers)
+                w.join();
+            for (size_t r = 1; r < regions; ++r)
+                regionAlgorithm(r).token = nullptr;
+        };
+        std::vector<std::thread> workers;
+        try {
+            for (size_t r = 1; r < regions; ++r)
+                workers.emplace_back(fill, r);
+        } catch (...) {
+            // Joinable threads can't be destroyed, the started regions are finished first
+            joinWorkers(workers);
+            throw;
+        }
+        fill(0);
+        joinWorkers(workers);
+        for (auto& e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
 
-                if (cur_layout.width - cur_layout.filled_width > circle.outRad() * 2) {
-                    auto new_layout = splitLayout(cur_layout, circle.outRad() * 2);
-                    y_pos = findMinHeight(new_layout, circle.inRad(), circle.outRad());
-                    if (y_pos) {
-                        new_layout.circles.push_back({ circle, {circle.outRad(), y_pos.value()} });
-                        new_layout.filled_width = new_layout.width;
-                        new_layout.filled_height = y_pos.value() + circle.outRad();
-                        layouts.push_back(new_layout);
-                        start = i;
-                        return true;
-                    }
+        // Layouts and circles of the other regions are appended to the ones of the first region
+        AreaLayouts merged = std::move(region_layouts[0]);
+        for (size_t r = 1; r < regions; ++r) {
+            auto& algorithm = regionAlgorithm(r);
+            size_t layouts_base = merged.size();
+            size_t circles_base = placed_circles.size();
+            for (size_t l = 0; l < region_layouts[r].size(); ++l) {
+                auto area = region_layouts[r].areas[l];
+                area.last_circle += circles_base;
+                merged.push_back(region_layouts[r].spaces[l], region_layouts[r].sides[l], area);
+            }
+            for (auto c : algorithm.placed_circles) {
+                c.layout += layouts_base;
+                placed_circles.push_back(c);
+            }
+            stats.addPlacementCounters(algorithm.stats);
+        }
+        layouts = std::move(merged);
+        for (auto status : statuses) {
+            if (status != SolveStatus::SOLVED)
+                return status;
+        }
+
+        // Reconciliation: circles which don't fit into their regions are placed into the space left by all of them
+        std::pmr::vector<size_t> rest(arena.resource());
+        for (auto& u : region_unplaced)
+            rest.insert(rest.end(), u.begin(), u.end());
+        auto out_rads = circles.getOutRads();
+        std::sort(rest.begin(), rest.end(), [&out_rads](size_t a, size_t b) {
+            return out_rads[a] > out_rads[b] || (out_rads[a] == out_rads[b] && a < b); });
+        ALGO_STATS_SET(stats, placement_regions, regions);
+        ALGO_STATS_SET(stats, reconciled_circles, rest.size());
+        if (rest.empty())
+            return SolveStatus::SOLVED;
+        sortLayouts(layouts);
+        return placeCircles(layouts, circles, rest, nullptr);
+    }
+
+    size_t GridBasedAlgorithm::placeRun(AreaLayouts& layouts, size_t layout_ind, const objects::CirclesView& circles,
+        const std::pmr::vector<size_t>& order, size_t from, size_t to) {
+        if (from >= to)
+            return 0;
+        auto& space = layouts.spaces[layout_ind];
+        auto& layout = layouts.areas[layout_ind];
+        auto circle = circles[order[from]];
+
+        // The layout holds the first circle of the run on the top, the next ones are put above it
+        // with the same x, every one is a diameter higher
+        auto position = placed_circles[layout.last_circle].position;
+        objects::Scalar diameter = circle.outRad() * 2;
+        objects::Scalar top_height = layouts.sides[layout_ind].leaningAllowed(TOP) ? circle.inRad() : circle.outRad();
+        objects::Scalar free_height = space.height - top_height - position.y;
+        size_t fit = (free_height > 0) ? std::min(to - from, static_cast<size_t>(free_height / diameter)) : 0;
+
+        for (size_t k = 0; k < fit; ++k) {
+            // Same sums as the placement of a single circle does, the last one is rechecked against rounding
+            objects::Scalar y = space.filled_height + circle.outRad();
+            if (space.height < y + top_height)
+                return k;
+            addCircle(layout, layout_ind, order[from + k], { position.x, y });
+            space.filled_height = y + circle.outRad();
+            ALGO_STATS_INC(stats, run_placements);
+        }
+        return fit;
+    }
+
+    bool GridBasedAlgorithm::placeCircle(AreaLayouts& layouts, LayoutIndex& index, size_t circle_ind, const objects::Circle& circle,
+        size_t& start) {
+        ALGO_STATS_INC(stats, place_circle_calls);
+        for (size_t i = selectLayout(index, circle, start, LayoutIndex::npos); i != LayoutIndex::npos;
+            i = selectLayout(index, circle, start, i)) {
+            size_t layout_ind = index.layout(i);
+            auto& cur_space = layouts.spaces[layout_ind];
+            auto& cur_sides = layouts.sides[layout_ind];
+            ALGO_STATS_INC(stats, layouts_scanned);
+
+            auto x_pos = findMinWidth(cur_space, cur_sides, circle.inRad(), circle.outRad());
+            auto y_pos = findMinHeight(cur_space, cur_sides, circle.inRad(), circle.outRad());
+
+            if (x_pos && y_pos) {
+                addCircle(layouts.areas[layout_ind], layout_ind, circle_ind, { x_pos.value(), y_pos.value() });
+                cur_space.filled_height = y_pos.value() + circle.outRad();
+                cur_space.filled_width = std::max(cur_space.filled_width, x_pos.value() + circle.outRad());
+                index.update(i, cur_space, cur_sides);
+                start = layout_ind;
+                return true;
+            }
+
+            if (cur_space.width - cur_space.filled_width > circle.outRad() * 2) {
+                auto [new_space, new_sides, new_layout] = splitLayout(cur_space, cur_sides, layouts.areas[layout_ind], circle.outRad() * 2);
+                y_pos = findMinHeight(new_space, new_sides, circle.inRad(), circle.outRad());
+                if (y_pos) {
+                    shrinkLayout(cur_space, cur_sides, circle.outRad() * 2);
+                    index.update(i, cur_space, cur_sides);
+
+                    addCircle(new_layout, layouts.size(), circle_ind, { circle.outRad(), y_pos.value() });
+                    new_space.filled_width = new_space.width;
+                    new_space.filled_height = y_pos.value() + circle.outRad();
+                    index.push_back(new_space, new_sides);
+                    layouts.push_back(new_space, new_sides, new_layout);
+                    start = layout_ind;
+                    return true;
                 }
             }
         }
         return false;
     }
 
-    std::optional<double> GridBasedAlgorithm::findMinWidth(const AreaLayout& layout, double inRad, double outRad) {
-        double min_width = layout.leaning_allowed[LEFT] ? inRad : outRad;
-        double needed_width = min_width + (layout.leaning_allowed[RIGHT] ? inRad : outRad);
+    void GridBasedAlgorithm::addCircle(AreaLayout& layout, size_t layout_ind, size_t circle_ind, objects::Point position) {
+        layout.last_circle = placed_circles.size();
+        placed_circles.push_back({ circle_ind, layout_ind, layout.circles_count++, position });
+    }
+
+    size_t GridBasedAlgorithm::selectLayout(const LayoutIndex& index, const objects::Circle& circle, size_t start, size_t previous) {
+        if (settings.selection == LayoutSelection::BEST_FIT) {
+            size_t to = (previous == LayoutIndex::npos) ? index.size() : previous;
+            return index.findLast(0, to, circle.inRad(), circle.outRad());
+        }
+
+        // Round-robin: [start, size) is searched first, then [0, start)
+        size_t size = index.size();
+        start = index.position(start);
+        if (start >= size)
+            start = 0;
+        size_t pos = LayoutIndex::npos;
+        if (previous == LayoutIndex::npos || previous >= start) {
+            size_t from = (previous == LayoutIndex::npos) ? start : previous + 1;
+            pos = index.findFirst(from, size, circle.inRad(), circle.outRad());
+            if (pos == LayoutIndex::npos)
+                pos = index.findFirst(0, start, circle.inRad(), circle.outRad());
+        } else {
+            pos = index.findFirst(previous + 1, start, circle.inRad(), circle.outRad());
+        }
+        return pos;
+    }
 
-        if (layout.width < needed_width)
+    std::optional<objects::Scalar> GridBasedAlgorithm::findMinWidth(const LayoutSpace& space, LayoutSides sides,
+        objects::Scalar inRad, objects::Scalar outRad) {
+        objects::Scalar min_width = sides.leaningAllowed(LEFT) ? inRad : outRad;
+        objects::Scalar needed_width = min_width + (sides.leaningAllowed(RIGHT) ? inRad : outRad);
+
+        if (space.width < needed_width) {
+            ALGO_STATS_INC(stats, width_rejections);
             return std::nullopt;
+        }
 
         return min_width;
     }
 
-    std::optional<double> GridBasedAlgorithm::findMinHeight(const AreaLayout& layout, double inRad, double outRad) {
-        double min_height = layout.filled_height + outRad;
-        if (layout.circles.empty())
-            min_height = layout.leaning_allowed[BOTTOM] ? inRad : outRad;
+    std::optional<objects::Scalar> GridBasedAlgorithm::findMinHeight(const LayoutSpace& space, LayoutSides sides,
+        objects::Scalar inRad, objects::Scalar outRad) {
+        objects::Scalar min_height = space.filled_height + outRad;
+        if (space.empty())
+            min_height = sides.leaningAllowed(BOTTOM) ? inRad : outRad;
 
-        double needed_height = min_height + (layout.leaning_allowed[TOP] ? inRad : outRad);
-        if (layout.height < needed_height)
+        objects::Scalar needed_height = min_height + (sides.leaningAllowed(TOP) ? inRad : outRad);
+        if (space.height < needed_height) {
+            ALGO_STATS_INC(stats, height_rejections);
             return std::nullopt;
+        }
 
         return min_height;
     }
 
-    AreaLayout GridBasedAlgorithm::splitLayout(AreaLayout& layout, double split_width) {
+    void GridBasedAlgorithm::sortLayouts(AreaLayouts& layouts) {
+        // Layouts are ordered by decreasing width, the permutation is sorted and then applied to both parts
+        auto resource = layouts.spaces.get_allocator().resource();
+        std::pmr::vector<size_t> order(layouts.size(), resource);
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        std::sort(order.begin(), order.end(), [&layouts](size_t a, size_t b) {
+            return layouts.spaces[a].width > layouts.spaces[b].width; });
+
+        AreaLayouts sorted(resource);
+        sorted.spaces.reserve(order.size());
+        sorted.areas.reserve(order.size());
+        for (auto i : order)
+            sorted.push_back(layouts.spaces[i], layouts.sides[i], layouts.areas[i]);
+        layouts = std::move(sorted);
+
+        // Circles placed before follow their layouts
+        if (!placed_circles.empty()) {
+            std::pmr::vector<size_t> position(order.size(), resource);
+            for (size_t i = 0; i < order.size(); ++i)
+                position[order[i]] = i;
+            for (auto& c : placed_circles)
+                c.layout = position[c.layout];
+        }
+    }
+
+    std::tuple<LayoutSpace, LayoutSides, AreaLayout> GridBasedAlgorithm::splitLayout(const LayoutSpace& space, LayoutSides sides,
+        const AreaLayout& layout, objects::Scalar split_width) {
+        ALGO_STATS_INC(stats, split_layouts);
         objects::Point min_point{ layout.min_point };
         if (layout.inverted)
-            min_point.y += layout.width - split_width;
+            min_point.y += space.width - split_width;
         else
-            min_point.x += layout.width - split_width;
+            min_point.x += space.width - split_width;
 
-        AreaLayout new_layout{ min_point, split_width, layout.height };
+        AreaLayout new_layout{ min_point };
         new_layout.inverted = layout.inverted;
-        new_layout.leaning_allowed = layout.leaning_allowed;
-        new_layout.leaning_allowed[LEFT] = false;
 
-        layout.width -= split_width;
-        layout.leaning_allowed[RIGHT] = false;
+        LayoutSpace new_space{ split_width, space.height };
+        LayoutSides new_sides = sides;
+        new_sides.setLeaningAllowed(LEFT, false);
+
+        return { new_space, new_sides, new_layout };
+    }
 
-        return new_layout;
+    void GridBasedAlgorithm::shrinkLayout(LayoutSpace& space, LayoutSides& sides, objects::Scalar split_width) {
+        space.width -= split_width;
+        sides.setLeaningAllowed(RIGHT, false);
     }
 
-    void GridBasedAlgorithm::relaxCircleDistribution(std::vector<AreaLayout>& layouts) {
-        for (auto& layout : layouts) {
-            if (!layout.circles.empty()) {
-                double x_offset = std::max(layout.width - layout.filled_width, 0.0);
-                double y_offset = (layout.height - layout.filled_height) / layout.circles.size();
-                for (size_t i = 0; i < layout.circles.size(); ++i) {
-                    layout.circles[i].position.y += y_offset * (i + 1);
-                    if (layout.width > layout.circles[i].outRad() * 2)
-                        layout.circles[i].position.x = layout.width / 2;
+    template<typename Kernel>
+    void GridBasedAlgorithm::forEachCirclesChunk(Kernel kernel) {
+        size_t count = placed_circles.size();
+        size_t chunks = (count >= parallel_positions_circles) ? std::max<size_t>(settings.positions_threads, 1) : 1;
+        if (chunks <= 1) {
+            kernel(size_t{ 0 }, count);
+            return;
+        }
+
+        // Circles are independent, every thread takes a contiguous chunk of them
+        if (!positions_pool)
+            positions_pool = std::make_unique<ThreadPool>(chunks - 1);
+        auto chunk = [&](size_t k) { kernel(count * k / chunks, count * (k + 1) / chunks); };
+        positions_pool->run(chunks, std::ref(chunk));
+    }
+
+    void GridBasedAlgorithm::relaxCircleDistribution(const AreaLayouts& layouts, const objects::CirclesView& circles) {
+        ALGO_STATS_TIMER(stats, relax_distribution_ms);
+        // The divisions are done once per layout instead of once per circle.
+        // A layout leaning on the top fits its last circle by the inner radius, but records the filled height
+        // with the outer one, so the free height can be negative and is clamped to keep the circles apart.
+        std::pmr::vector<RelaxOffsets> offsets(layouts.size(), arena.resource());
+        for (size_t l = 0; l < layouts.size(); ++l) {
+            auto& space = layouts.spaces[l];
+            auto count = layouts.areas[l].circles_count;
+            offsets[l].x_offset = std::max(space.width - space.filled_width, objects::Scalar{ 0 });
+            offsets[l].y_offset = count ? std::max(space.height - space.filled_height, objects::Scalar{ 0 }) / count : 0;
+            offsets[l].width = space.width;
+            offsets[l].center = space.width / 2;
+        }
+
+        auto out_rads = circles.getOutRads();
+        forEachCirclesChunk([this, &offsets, out_rads](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto& c = placed_circles[i];
+                auto& o = offsets[c.layout];
+                objects::Scalar shifted = c.position.x + o.x_offset;
+                c.position.y += o.y_offset * (c.slot + 1);
+                c.position.x = (o.width > out_rads[c.circle] * 2) ? o.center : shifted;
+            }
+        });
+    }
+
+    void GridBasedAlgorithm::recalculateCirclesPositions(const AreaLayouts& layouts) {
+        ALGO_STATS_TIMER(stats, recalculate_positions_ms);
+        // Blocks of circles are split into straight and inverted runs, every run is gathered by its own kernel
+        forEachCirclesChunk([this, &layouts](size_t begin, size_t end) {
+            PositionsBlock block;
+            for (size_t from = begin; from < end; from += PositionsBlock::capacity) {
+                size_t count = std::min(end - from, PositionsBlock::capacity);
+                size_t straight = 0;
+                size_t inverted = count;
+                for (size_t i = from; i < from + count; ++i) {
+                    if (layouts.areas[placed_circles[i].layout].inverted)
+                        block.circles[--inverted] = i;
                     else
-                        layout.circles[i].position.x += x_offset;
+                        block.circles[straight++] = i;
+                }
+
+                gatherPositions<false>(layouts, block, 0, straight);
+                gatherPositions<true>(layouts, block, straight, count);
+                for (size_t k = 0; k < count; ++k) {
+                    block.along[k] += block.origin_x[k];
+                    block.across[k] += block.origin_y[k];
                 }
+                for (size_t k = 0; k < count; ++k)
+                    placed_circles[block.circles[k]].position = { block.along[k], block.across[k] };
             }
-        }
+        });
     }
 
-    void GridBasedAlgorithm::recalculateCirclesPositions(std::vector<AreaLayout>& layouts) {
-        for (auto& l : layouts) {
-            for (auto& c : l.circles) {
-                double x = l.min_point.x + (l.inverted ? c.position.y : c.position.x);
-                double y = l.min_point.y + (l.inverted ? c.position.x : c.position.y);
-                c.position = { x, y };
-            }
+    template<bool Inverted>
+    void GridBasedAlgorithm::gatherPositions(const AreaLayouts& layouts, PositionsBlock& block, size_t from, size_t to) {
+        for (size_t k = from; k < to; ++k) {
+            auto& c = placed_circles[block.circles[k]];
+            auto& origin = layouts.areas[c.layout].min_point;
+            block.along[k] = Inverted ? c.position.y : c.position.x;
+            block.across[k] = Inverted ? c.position.x : c.position.y;
+            block.origin_x[k] = origin.x;
+            block.origin_y[k] = origin.y;
         }
     }
 
@@ -2,38 +2,168 @@
 
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
+#include "AlgorithmStats.hpp"
 #include "AreasGrid.hpp"
+#include "CancellationToken.hpp"
+#include "LayoutIndex.hpp"
+#include "SolveArena.hpp"
+#include "ThreadPool.hpp"
 #include "objects.hpp"
 
 namespace algo{ 
     class Algorithm {
     public:
         virtual std::optional<objects::ResultData> calculate(const objects::Scene& scene) = 0;
+        // Solves a scene kept in caller's arrays, they are read in place and have to outlive the call
+        virtual std::optional<objects::ResultData> calculate(const objects::SceneView& scene) = 0;
         virtual ~Algorithm() = default;
     };
 
     std::unique_ptr<Algorithm> createDefaultAlgorithm();
 
+    enum class LayoutSelection {
+        FIRST_FIT,  // round-robin over layouts starting after the last used one
+        BEST_FIT    // the last suitable layout in index order: layouts start sorted by decreasing width, split parts are appended
+    };
+
+    enum class SolveStatus {
+        SOLVED,
+        FAILED,     // the circles can't be placed
+        CANCELLED,  // the token was cancelled, the result keeps the circles placed so far
+        TIMED_OUT   // the token deadline passed, the result keeps the circles placed so far
+    };
+
+    struct AlgorithmSettings {
+        // Only BEST_FIT stacks runs of equal circles into a layout at once. FIRST_FIT moves to the next layout after
+        // every circle, so the circles of a run go to different layouts and each one takes an index query,
+        // logarithmic in the layouts count.
+        LayoutSelection selection{ LayoutSelection::FIRST_FIT };
+        // Maximal number of threads used to build big grids
+        size_t grid_threads{ 1 };
+        // Threads placing the circles of big scenes, every one fills its own region of the zone.
+        // The placement then differs from the single thread one and may fail on scenes that one solves.
+        size_t placement_threads{ 1 };
+        // Threads computing the final positions of the circles of big scenes, the positions don't depend on it
+        size_t positions_threads{ 1 };
+        // Dense grid size (bytes) from which the grid keeps only free intervals of its rows
+        size_t grid_memory_budget{ AreasGrid::default_memory_budget };
+        GridCalculationMode grid_mode{ GridCalculationMode::HORIZONTAL };
+        // Layouts orientation, circles are stacked along the layouts height
+        LayoutAlignment alignment{ LayoutAlignment::WIDTH_LESS };
+        // Exclusion areas coordinates closer than it are merged into one grid line
+        objects::Scalar snap_epsilon{ 0.0 };
+        // Results are checked for overlapping circles and circles leaving the zone or entering exclusion areas,
+        // the solve fails if any is found. It is on by default in single precision, where rounding may move circles
+        // closer than their radiuses.
+        bool verify_results{ std::is_same_v<objects::Scalar, float> };
+        // Overlap allowed by the check, in roundings of the biggest absolute zone coordinate (its value times the
+        // scalar epsilon). Solves round by about one.
+        double verify_tolerance{ 8.0 };
+        // Solve memory (bytes) kept for the next solves at most, bigger solves take the rest from the heap every time
+        size_t solve_memory_limit{ SolveArena::default_retained_limit };
+    };
+
+    // Keeps the memory of its solves, so an instance can't be used by several threads at once (see BatchSolver)
 	class GridBasedAlgorithm : public Algorithm {
     public:
+        explicit GridBasedAlgorithm(const AlgorithmSettings& settings = {});
+
         std::optional<objects::ResultData> calculate(const objects::Scene& scene) override;
+        std::optional<objects::ResultData> calculate(const objects::SceneView& scene) override;
+        // Same as calculate, statistics of the solve are written to out_stats
+        std::optional<objects::ResultData> calculate(const objects::SceneView& scene, AlgorithmStats& out_stats);
+        // Same as calculate, the circles are written to result reusing its memory. Returns false if they can't be placed.
+        // Solving similar scenes into the same result doesn't allocate from the heap after the first solve.
+        bool calculate(const objects::SceneView& scene, objects::ResultData& result);
+        bool calculate(const objects::SceneView& scene, objects::ResultData& result, AlgorithmStats& out_stats);
+
+        // Same as calculate, the solve stops once the token is cancelled or its deadline passes. The circles placed
+        // by then are written to result at their final positions, but they are not spread over the free space.
+        SolveStatus calculate(const objects::SceneView& scene, objects::ResultData& result, const CancellationToken& token);
 
     private:
-        std::unique_ptr<AreasGrid> grid;
+        AlgorithmSettings settings;
+        // Placements between the token checks, the deadline check reads the clock
+        static constexpr size_t stop_check_period = 64;
+        // Circles count from which the placement is split between regions
+        static constexpr size_t parallel_placement_circles = size_t{ 1 } << 16;
+        // Circles count from which the positions are computed by several threads
+        static constexpr size_t parallel_positions_circles = size_t{ 1 } << 16;
+
+        // Offsets of the circles of a layout spread over its free space, computed once per layout
+        struct RelaxOffsets {
+            objects::Scalar x_offset;
+            objects::Scalar y_offset;
+            objects::Scalar width;
+            objects::Scalar center;
+        };
+        // Circles of a block of the positions pass, the ones of straight layouts come first. The coordinates are
+        // gathered along and across the layout, so every run is moved by the same adds over plain arrays.
+        struct PositionsBlock {
+            static constexpr size_t capacity = 256;
+            size_t circles[capacity];
+            objects::Scalar along[capacity];
+            objects::Scalar across[capacity];
+            objects::Scalar origin_x[capacity];
+            objects::Scalar origin_y[capacity];
+        };
+        const CancellationToken* token{};
+        // Memory of a single solve: the grid, the layouts and the placement buffers are released at once
+        // when the solve ends, only the result is allocated outside of it. The arena keeps its memory for the next solve.
+        SolveArena arena;
+        std::optional<AreasGrid> grid;
+        AlgorithmStats stats;
+        // Circles of all the layouts in the placement order
+        std::pmr::vector<PlacedCircle> placed_circles{ arena.resource() };
+        // Fill the regions other than the first one in parallel placement
+        std::vector<std::unique_ptr<GridBasedAlgorithm>> region_algorithms;
+        // Threads of the positions passes, created by the first big scene and kept for the next solves
+        std::unique_ptr<ThreadPool> positions_pool;
 
-        void initGrid(const objects::Rectangle& zone, const std::vector<objects::Rectangle>& exclusion_areas);
+        // Every solve goes through it, stop_token may be nullptr
+        SolveStatus run(const objects::SceneView& scene, objects::ResultData& result, const CancellationToken* stop_token);
+        SolveStatus solve(const objects::SceneView& scene, objects::ResultData& result);
+        void releaseSolveMemory();
+        bool stopRequested() const { return token && token->stopRequested(); }
+        SolveStatus stopStatus() const { return token->isCancelled() ? SolveStatus::CANCELLED : SolveStatus::TIMED_OUT; }
+        void initGrid(const objects::Rectangle& zone, objects::ArrayView<objects::Rectangle> exclusion_areas);
 
-        bool fillLayouts(std::vector<AreaLayout>& layouts, std::vector<objects::Circle> circles);
-        bool placeCircle(std::vector<AreaLayout>& layouts, objects::Circle& circle, size_t& start);
+        SolveStatus fillLayouts(AreaLayouts& layouts, const objects::CirclesView& circles);
+        // Places the circles in the order, the ones which can't be placed are left in unplaced or fail the placement if it's nullptr
+        SolveStatus placeCircles(AreaLayouts& layouts, const objects::CirclesView& circles, const std::pmr::vector<size_t>& order,
+            std::pmr::vector<size_t>* unplaced);
+        // Splits the layouts into regions filled by separate threads, then places the circles left by the regions anywhere
+        SolveStatus fillRegions(AreaLayouts& layouts, const objects::CirclesView& circles, const std::pmr::vector<size_t>& order,
+            size_t regions);
+        bool placeCircle(AreaLayouts& layouts, LayoutIndex& index, size_t circle_ind, const objects::Circle& circle, size_t& start);
+        void addCircle(AreaLayout& layout, size_t layout_ind, size_t circle_ind, objects::Point position);
+        // Stacks equal circles order[from, to) above the last circle of the layout, returns the number placed
+        size_t placeRun(AreaLayouts& layouts, size_t layout_ind, const objects::CirclesView& circles,
+            const std::pmr::vector<size_t>& order, size_t from, size_t to);
+        size_t selectLayout(const LayoutIndex& index, const objects::Circle& circle, size_t start, size_t previous);
 
-        std::optional<double> findMinWidth(const AreaLayout& layout, double inRad, double outRad);
-        std::optional<double> findMinHeight(const AreaLayout& layout, double inRad, double outRad);
+        std::optional<objects::Scalar> findMinWidth(const LayoutSpace& space, LayoutSides sides, objects::Scalar inRad, objects::Scalar outRad);
+        std::optional<objects::Scalar> findMinHeight(const LayoutSpace& space, LayoutSides sides, objects::Scalar inRad, objects::Scalar outRad);
 
-        AreaLayout splitLayout(AreaLayout& layout, double split_width);
+        void sortLayouts(AreaLayouts& layouts);
+        std::tuple<LayoutSpace, LayoutSides, AreaLayout> splitLayout(const LayoutSpace& space, LayoutSides sides, const AreaLayout& layout,
+            objects::Scalar split_width);
+        void shrinkLayout(LayoutSpace& space, LayoutSides& sides, objects::Scalar split_width);
                  
-        void relaxCircleDistribution(std::vector<AreaLayout>& layouts);
-        void recalculateCirclesPositions(std::vector<AreaLayout>& layouts);
+        void relaxCircleDistribution(const AreaLayouts& layouts, const objects::CirclesView& circles);
+        void recalculateCirclesPositions(const AreaLayouts& layouts);
+        // Gathers the circles of the block runs in the layout coordinates, the inverted ones with the coordinates swapped
+        template<bool Inverted>
+        void gatherPositions(const AreaLayouts& layouts, PositionsBlock& block, size_t from, size_t to);
+        bool verifyResults(const objects::SceneView& scene, const objects::ResultData& result);
+        // Runs kernel(begin, end) over chunks of the placed circles, in parallel for big scenes
+        template<typename Kernel>
+        void forEachCirclesChunk(Kernel kernel);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace algo {
+    // Solve statistics. They are collected only when CIRCLES_ALGORITHM_STATS is defined (the benchmark project defines it),
+    // otherwise all the counters stay zero and the collecting code is compiled out.
+    struct AlgorithmStats {
+        double init_grid_ms{};
+        double allowed_areas_ms{};
+        double fill_layouts_ms{};
+        double relax_distribution_ms{};
+        double recalculate_positions_ms{};
+        double verify_results_ms{};
+
+        size_t allowed_layouts{};
+        size_t place_circle_calls{};
+        size_t run_placements{};
+        size_t layouts_scanned{};
+        size_t split_layouts{};
+        size_t width_rejections{};
+        size_t height_rejections{};
+        size_t placement_violations{};
+        // Parallel placement: regions filled by separate threads and circles placed after them
+        size_t placement_regions{};
+        size_t reconciled_circles{};
+
+        // Adds the placement counters of a solve part
+        void addPlacementCounters(const AlgorithmStats& other) {
+            place_circle_calls += other.place_circle_calls;
+            run_placements += other.run_placements;
+            layouts_scanned += other.layouts_scanned;
+            split_layouts += other.split_layouts;
+            width_rejections += other.width_rejections;
+            height_rejections += other.height_rejections;
+        }
+
+        double layoutsScannedPerPlacement() const {
+            return place_circle_calls ? static_cast<double>(layouts_scanned) / place_circle_calls : 0.0;
+        }
+    };
+
+#ifdef CIRCLES_ALGORITHM_STATS
+    class PhaseTimer {
+    public:
+        explicit PhaseTimer(double& target_ms) : target_ms{ target_ms }, start{ std::chrono::steady_clock::now() } {}
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+        ~PhaseTimer() {
+            target_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    private:
+        double& target_ms;
+        std::chrono::steady_clock::time_point start;
+    };
+
+#define ALGO_STATS_TIMER(stats, field) ::algo::PhaseTimer phase_timer_##field{ (stats).field }
+#define ALGO_STATS_INC(stats, field) (++(stats).field)
+#define ALGO_STATS_SET(stats, field, value) ((stats).field = (value))
+#else
+#define ALGO_STATS_TIMER(stats, field)
+#define ALGO_STATS_INC(stats, field) ((void)0)
+#define ALGO_STATS_SET(stats, field, value) ((void)0)
+#endif
+}
@@ -5,32 +5,39 @@
 
 namespace algo {
 
-    void AreaLayout::applyAlignment(LayoutAlignment align) {
+    void applyAlignment(LayoutSpace& space, LayoutSides& sides, AreaLayout& layout, LayoutAlignment align) {
         bool new_invert{};
         if (align == LayoutAlignment::HEIGHT_LESS) 
-            new_invert = (height > width);
+            new_invert = (space.height > space.width);
 
         if (align == LayoutAlignment::WIDTH_LESS)
-            new_invert = (width > height);
+            new_invert = (space.width > space.height);
 
         if (new_invert) {
-            std::swap(width, height);
-            std::swap(leaning_allowed[LEFT], leaning_allowed[BOTTOM]);
-            std::swap(leaning_allowed[RIGHT], leaning_allowed[TOP]);
-            inverted = !inverted;
+            std::swap(space.width, space.height);
+            bool left = sides.leaningAllowed(LEFT);
+            bool right = sides.leaningAllowed(RIGHT);
+            sides.setLeaningAllowed(LEFT, sides.leaningAllowed(BOTTOM));
+            sides.setLeaningAllowed(RIGHT, sides.leaningAllowed(TOP));
+            sides.setLeaningAllowed(BOTTOM, left);
+            sides.setLeaningAllowed(TOP, right);
+            layout.inverted = !layout.inverted;
         }
     }
 
+    std::ostream& operator<< (std::ostream& out, const LayoutSpace& s) {
+        out << "w: " << s.filled_width << "/" << s.width << " h: " << s.filled_height << "/" << s.height << "\n";
+        return out;
+    }
+
+    std::ostream& operator<< (std::ostream& out, const LayoutSides& s) {
+        out << "LRBT: " << s.leaningAllowed(LEFT) << " " << s.leaningAllowed(RIGHT) << " " <<
+            s.leaningAllowed(BOTTOM) << " " << s.leaningAllowed(TOP) << "\n";
+        return out;
+    }
+
     std::ostream& operator<< (std::ostream& out, const AreaLayout& l) {
-        out << l.min_point << " w: " << l.filled_width << "/" << l.width << " h: " << l.filled_height << "/" << l.height << "\n";
-        out << "inverted: " << l.inverted << " filled: " << l.filled;
-        out << " LRBT: " << l.leaning_allowed[LEFT] << " " << l.leaning_allowed[RIGHT] << " " <<
-            l.leaning_allowed[BOTTOM] << " " << l.leaning_allowed[TOP] << "\n";
-        if (!l.circles.empty()) {
-            out << "Circles: \n";
-            for (auto& c : l.circles)
-                out << c << "\n";
-        }
+        out << l.min_point << " inverted: " << l.inverted << " circles: " << l.circles_count << "\n";
         return out;
     }
 }
\ No newline at end of file
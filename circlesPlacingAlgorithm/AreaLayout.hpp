@@ -1,7 +1,9 @@
 #pragma once
 
 #include <iosfwd>
-#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
 
 #include "objects.hpp"
 
@@ -14,26 +16,95 @@ namespace algo {
 		WIDTH_LESS, HEIGHT_LESS, NO_ALIGH
 	};
 
+	// Circle placed into a layout, the position is relative to the layout until the positions are recalculated
+	struct PlacedCircle {
+		size_t circle;  // index in the scene circles
+		size_t layout;
+		size_t slot;    // number of the circle in its layout, counted from the bottom
+		objects::Point position;
+	};
+
+	class AreaLayout;
+	class LayoutSides;
 	class AreasGrid;
 	class GridBasedAlgorithm;
+	class LayoutIndex;
+
+	// Part of a layout read by every placement attempt, the sizes are in the layout coordinates
+	class LayoutSpace {
+	private:
+		LayoutSpace(objects::Scalar w, objects::Scalar h) : width{ w }, height{ h } {}
+
+		// Any placed circle leaves a positive filled height
+		bool empty() const { return filled_height == 0; }
+
+		objects::Scalar width{};
+		objects::Scalar height{};
+		objects::Scalar filled_width{};
+		objects::Scalar filled_height{};
 
+		friend AreasGrid;
+		friend GridBasedAlgorithm;
+		friend LayoutIndex;
+		friend void applyAlignment(LayoutSpace& space, LayoutSides& sides, AreaLayout& layout, LayoutAlignment align);
+		friend std::ostream& operator<< (std::ostream& out, const LayoutSpace& s);
+	};
+
+	// The leaning flags are kept apart in LayoutSides, so the record is the four sizes: two records per 64 bytes cache line
+	static_assert(sizeof(LayoutSpace) <= 32, "LayoutSpace is expected to fit in 32 bytes");
+
+	// Sides of a layout which circles may lean on, touching them with the inner radius
+	class LayoutSides {
+	private:
+		bool leaningAllowed(RectangleSides side) const { return (bits >> side) & 1; }
+		void setLeaningAllowed(RectangleSides side, bool value) {
+			bits = static_cast<uint8_t>(value ? bits | (1 << side) : bits & ~(1 << side));
+		}
+
+		// Bits by RectangleSides
+		uint8_t bits{};
+
+		friend AreasGrid;
+		friend GridBasedAlgorithm;
+		friend LayoutIndex;
+		friend void applyAlignment(LayoutSpace& space, LayoutSides& sides, AreaLayout& layout, LayoutAlignment align);
+		friend std::ostream& operator<< (std::ostream& out, const LayoutSides& s);
+	};
+
+	// Part of a layout used once a circle is placed into it
 	class AreaLayout {
 	private:
-		AreaLayout(objects::Point point, double w, double h) : min_point{ point }, width{ w }, height{ h } {}
-		void applyAlignment(LayoutAlignment align);
+		explicit AreaLayout(objects::Point point) : min_point{ point } {}
 
 		objects::Point min_point{};
-		double width{};
-		double height{};
-		double filled_width{};
-		double filled_height{};
 		bool inverted{};
-		bool filled{};
-		std::array<bool, 4> leaning_allowed{};
-		std::vector<objects::PositionedCircle> circles;
+		// Circles of the layout are kept in the common placed circles buffer
+		size_t circles_count{};
+		size_t last_circle{};
 
 		friend AreasGrid;
 		friend GridBasedAlgorithm;
+		friend void applyAlignment(LayoutSpace& space, LayoutSides& sides, AreaLayout& layout, LayoutAlignment align);
 		friend std::ostream& operator<< (std::ostream& out, const AreaLayout& l);
 	};
+
+	// Layouts as parallel arrays of their parts, the i-th layout is {spaces[i], sides[i], areas[i]}
+	struct AreaLayouts {
+		std::pmr::vector<LayoutSpace> spaces;
+		std::pmr::vector<LayoutSides> sides;
+		std::pmr::vector<AreaLayout> areas;
+
+		explicit AreaLayouts(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+			spaces{ resource }, sides{ resource }, areas{ resource } {}
+
+		size_t size() const { return spaces.size(); }
+		void push_back(const LayoutSpace& space, LayoutSides side, const AreaLayout& area) {
+			spaces.push_back(space);
+			sides.push_back(side);
+			areas.push_back(area);
+		}
+	};
+
+	// Swaps the layout sides if needed, so that its width is less or greater than its height
+	void applyAlignment(LayoutSpace& space, LayoutSides& sides, AreaLayout& layout, LayoutAlignment align);
 }
\ No newline at end of file
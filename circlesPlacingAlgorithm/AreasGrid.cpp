@@ -1,94 +1,355 @@
 #include "AreasGrid.hpp"
 
 #include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
 #include <ostream>
+#include <thread>
+#include <utility>
 
 namespace algo {
-    AreasGrid::AreasGrid(const objects::Rectangle& zone, const std::vector<objects::Rectangle>& exclusion_areas) {
+    AreasGrid::AreasGrid(const objects::Rectangle& zone, objects::ArrayView<objects::Rectangle> exclusion_areas, size_t threads,
+        size_t memory_budget, objects::Scalar snap_epsilon, std::pmr::memory_resource* resource, const CancellationToken* token) :
+        resource{ resource }, token{ token }, threads{ std::max<size_t>(threads, 1) }, memory_budget{ memory_budget },
+        snap_epsilon{ std::max(snap_epsilon, objects::Scalar{ 0 }) }, grid{ resource }, interval_offsets{ resource }, intervals{ resource },
+        x_values{ resource }, y_values{ resource }, x_max_values{ resource }, y_max_values{ resource } {
         fillCoordsValues(zone, exclusion_areas);
         fillGrid(exclusion_areas);
     }
 
-    void AreasGrid::fillCoordsValues(const objects::Rectangle& zone, const std::vector<objects::Rectangle>& exclusion_areas) {
-        x_values = { zone.minPoint().x, zone.maxPoint().x };
-        y_values = { zone.minPoint().y, zone.maxPoint().y };
+    void AreasGrid::fillCoordsValues(const objects::Rectangle& zone, objects::ArrayView<objects::Rectangle> exclusion_areas) {
+        x_values.reserve(exclusion_areas.size() * 2 + 2);
+        y_values.reserve(exclusion_areas.size() * 2 + 2);
+        x_values.insert(x_values.end(), { zone.minPoint().x, zone.maxPoint().x });
+        y_values.insert(y_values.end(), { zone.minPoint().y, zone.maxPoint().y });
 
         for (auto& area : exclusion_areas) {
             x_values.insert(x_values.end(), { area.minPoint().x, area.maxPoint().x });
             y_values.insert(y_values.end(), { area.minPoint().y, area.maxPoint().y });
         }
 
-        std::sort(x_values.begin(), x_values.end());
-        std::sort(y_values.begin(), y_values.end());
-        x_values.erase(std::unique(x_values.begin(), x_values.end()), x_values.end());
-        y_values.erase(std::unique(y_values.begin(), y_values.end()), y_values.end());
+        snapValues(x_values, x_max_values);
+        snapValues(y_values, y_max_values);
+        splitCollapsedLines(exclusion_areas, &objects::Point::x, x_values, x_max_values);
+        splitCollapsedLines(exclusion_areas, &objects::Point::y, y_values, y_max_values);
     }
 
-    void AreasGrid::fillGrid(const std::vector<objects::Rectangle>& exclusion_areas) {
+    void AreasGrid::snapValues(std::pmr::vector<objects::Scalar>& values, std::pmr::vector<objects::Scalar>& max_values) const {
+        std::sort(values.begin(), values.end());
+        max_values.clear();
+        max_values.reserve(values.size());
+
+        // Values not farther than snap_epsilon from the smallest value of a group become one grid line,
+        // the group keeps its smallest value in values and its biggest one in max_values
+        size_t count = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (count > 0 && values[i] - values[count - 1] <= snap_epsilon) {
+                max_values[count - 1] = values[i];
+                continue;
+            }
+            values[count++] = values[i];
+            max_values.push_back(values[i]);
+        }
+        values.resize(count);
+    }
+
+    void AreasGrid::splitCollapsedLines(objects::ArrayView<objects::Rectangle> exclusion_areas, objects::Scalar objects::Point::* coord,
+        std::pmr::vector<objects::Scalar>& values, std::pmr::vector<objects::Scalar>& max_values) const {
+        // An area snapped into a single inner line covers no cell, so the runs would cross it. Such a line gets
+        // a zero width cell after it, at its biggest value, which the area covers instead.
+        std::pmr::vector<bool> collapsed(values.size(), false, resource);
+        bool any = false;
+        for (auto& area : exclusion_areas) {
+            size_t line = snappedIndex(values, area.minPoint().*coord);
+            if (line > 0 && line + 1 < values.size() && line == snappedIndex(values, area.maxPoint().*coord)) {
+                collapsed[line] = true;
+                any = true;
+            }
+        }
+        if (!any)
+            return;
+
+        std::pmr::vector<objects::Scalar> split_values(resource), split_max_values(resource);
+        split_values.reserve(values.size() * 2);
+        split_max_values.reserve(values.size() * 2);
+        for (size_t i = 0; i < values.size(); ++i) {
+            split_values.push_back(values[i]);
+            split_max_values.push_back(max_values[i]);
+            if (collapsed[i]) {
+                split_values.push_back(max_values[i]);
+                split_max_values.push_back(max_values[i]);
+            }
+        }
+        values.swap(split_values);
+        max_values.swap(split_max_values);
+    }
+
+    size_t AreasGrid::snappedIndex(const std::pmr::vector<objects::Scalar>& values, objects::Scalar value) {
+        auto it = std::upper_bound(values.begin(), values.end(), value);
+        return (it == values.begin()) ? 0 : std::distance(values.begin(), it) - 1;
+    }
+
+    void AreasGrid::fillGrid(objects::ArrayView<objects::Rectangle> exclusion_areas) {
         auto xSize = x_values.size() - 1;
         auto ySize = y_values.size() - 1;
-        grid = std::vector<bool>(ySize * xSize, true);
+
+        // Every area opens at its bottom row and closes at its top row. The events are bucketed
+        // by row (counting sort), so that the grid is filled by a single sweep over the rows.
+        std::pmr::vector<size_t> row_offsets(ySize + 2, 0, resource);
+        std::pmr::vector<GridEvent> events(exclusion_areas.size() * 2, resource);
+        std::pmr::vector<std::array<size_t, 4>> bounds(resource);
+        bounds.reserve(exclusion_areas.size());
         for (auto& area : exclusion_areas) {
-            auto xMinIt = std::lower_bound(x_values.begin(), x_values.end(), area.minPoint().x);
-            auto xMaxIt = std::lower_bound(xMinIt, x_values.end(), area.maxPoint().x);
-            auto yMinIt = std::lower_bound(y_values.begin(), y_values.end(), area.minPoint().y);
-            auto yMaxIt = std::lower_bound(yMinIt, y_values.end(), area.maxPoint().y);
-
-            auto xMin = std::distance(x_values.begin(), xMinIt);
-            auto xMax = std::distance(x_values.begin(), xMaxIt);
-            auto yMin = std::distance(y_values.begin(), yMinIt);
-            auto yMax = std::distance(y_values.begin(), yMaxIt);
-
-            for (auto i = yMin; i < yMax; ++i) {
-                std::fill(grid.begin() + xSize * i + xMin, grid.begin() + xSize * i + xMax, false);
-            }
+            size_t xMin = snappedIndex(x_values, area.minPoint().x);
+            size_t xMax = snappedIndex(x_values, area.maxPoint().x);
+            size_t yMin = snappedIndex(y_values, area.minPoint().y);
+            size_t yMax = snappedIndex(y_values, area.maxPoint().y);
+            // Areas inside an inner line take the zero width cell split after it
+            if (xMin == xMax && xMin > 0 && xMin < xSize)
+                ++xMax;
+            if (yMin == yMax && yMin > 0 && yMin < ySize)
+                ++yMax;
+            if (xMin >= xMax || yMin >= yMax)
+                continue;
+
+            bounds.push_back({ xMin, xMax, yMin, yMax });
+            row_offsets[yMin + 1]++;
+            row_offsets[yMax + 1]++;
+        }
+        for (size_t i = 1; i < row_offsets.size(); ++i)
+            row_offsets[i] += row_offsets[i - 1];
+
+        std::pmr::vector<size_t> next(row_offsets, resource);
+        for (auto& b : bounds) {
+            events[next[b[2]]++] = { b[0], b[1], 1 };
+            events[next[b[3]]++] = { b[0], b[1], -1 };
+        }
+
+        // The dense grid is quadratic in the areas count, so huge scenes keep only the free intervals of the rows
+        size_t row_bytes = (xSize + 63) / 64 * sizeof(std::uint64_t);
+        sparse = ySize > 0 && row_bytes > memory_budget / ySize;
+        if (sparse) {
+            fillIntervals(row_offsets, events);
+            return;
+        }
+        grid = BitGrid(xSize, ySize, false, resource);
+
+        // Rows are independent once the coverage at the band beginning is known, so big grids are split
+        // into bands filled in parallel
+        size_t bands = (xSize * ySize >= parallel_fill_cells) ? std::min(threads, ySize) : 1;
+        if (bands <= 1) {
+            fillRows(0, ySize, row_offsets, events, resource);
+            return;
         }
+
+        // The resource is not thread safe, the other threads take their row buffers from the default heap
+        std::vector<std::thread> workers;
+        try {
+            for (size_t b = 1; b < bands; ++b)
+                workers.emplace_back(&AreasGrid::fillRows, this, ySize * b / bands, ySize * (b + 1) / bands,
+                    std::cref(row_offsets), std::cref(events), std::pmr::get_default_resource());
+        } catch (...) {
+            // Joinable threads can't be destroyed, the started ones finish their bands first
+            for (auto& w : workers)
+                w.join();
+            throw;
+        }
+        fillRows(0, ySize / bands, row_offsets, events, resource);
+        for (auto& w : workers)
+            w.join();
     }
 
-    std::vector<AreaLayout> AreasGrid::calculateAllowedAreas(GridCalculationMode mode, LayoutAlignment align) {
-        if (mode == GridCalculationMode::HORIZONTAL) {
-            auto layouts = calculateHorizontalAllowedAreas();
-            for (auto& l : layouts)
-                l.applyAlignment(align);
-            return layouts;
+    void AreasGrid::fillRows(size_t row_begin, size_t row_end, const std::pmr::vector<size_t>& row_offsets,
+        const std::pmr::vector<GridEvent>& events, std::pmr::memory_resource* buffers) {
+        auto xSize = grid.width();
+
+        // diff[j] = coverage[j] - coverage[j - 1] for the current row, where coverage is the number of areas
+        // covering the cell. Nonzero entries are marked in a bit row, so a row is processed in
+        // O(xSize / 64 + areas boundaries) instead of a cell by cell prefix sum.
+        std::pmr::vector<int> diff(xSize + 1, 0, buffers);
+        BitGrid nonzero(xSize + 1, 1, false, buffers);
+        auto apply = [&](const GridEvent& e) {
+            diff[e.x0] += e.delta;
+            diff[e.x1] -= e.delta;
+            nonzero.setRange(0, e.x0, e.x0 + 1, diff[e.x0] != 0);
+            nonzero.setRange(0, e.x1, e.x1 + 1, diff[e.x1] != 0);
+        };
+
+        for (size_t e = 0; e < row_offsets[row_begin]; ++e)
+            apply(events[e]);
+
+        for (size_t i = row_begin; i < row_end; ++i) {
+            if (stopRequested(i - row_begin))
+                return;
+            for (size_t e = row_offsets[i]; e < row_offsets[i + 1]; ++e)
+                apply(events[e]);
+
+            int coverage = 0;
+            size_t pos = 0;
+            for (size_t j = nonzero.findSet(0, 0); j < xSize; j = nonzero.findSet(0, j + 1)) {
+                if (coverage == 0)
+                    grid.setRange(i, pos, j, true);
+                coverage += diff[j];
+                pos = j;
+            }
+            if (coverage == 0)
+                grid.setRange(i, pos, xSize, true);
         }
     }
 
-    std::vector<AreaLayout> AreasGrid::calculateHorizontalAllowedAreas() {
-        std::vector<AreaLayout> result;
+    void AreasGrid::fillIntervals(const std::pmr::vector<size_t>& row_offsets, const std::pmr::vector<GridEvent>& events) {
         auto xSize = x_values.size() - 1;
         auto ySize = y_values.size() - 1;
 
+        // Sweep line over the rows, only the nonzero coverage differences of the current row are kept
+        std::pmr::map<size_t, int> diff(resource);
+        auto change = [&diff](size_t x, int delta) {
+            auto it = diff.emplace(x, 0).first;
+            it->second += delta;
+            if (it->second == 0)
+                diff.erase(it);
+        };
+
+        interval_offsets.assign(1, 0);
+        interval_offsets.reserve(ySize + 1);
+        intervals.clear();
         for (size_t i = 0; i < ySize; ++i) {
-            for (size_t j = 0; j < xSize; ++j) {
-                auto beginInd = i * xSize + j;
-                if (grid[beginInd]) {
-                    auto j0 = j;
-                    auto rowBeginInd = i * xSize;
-                    auto rowEndInd = (i + 1) * xSize;
-                    auto endInd = std::adjacent_find(grid.begin() + beginInd, grid.begin() + rowEndInd, std::not_equal_to<bool>());
-                    if (endInd == grid.begin() + rowEndInd)
-                        endInd--;
-                    j = std::distance(grid.begin() + rowBeginInd, endInd);
-
-                    AreaLayout layout = createAreaLayout(j0, j+1, i, i+1);
-                    layout.leaning_allowed[LEFT] = true;
-                    layout.leaning_allowed[RIGHT] = true;
-                    layout.leaning_allowed[BOTTOM] = (i == 0);
-                    layout.leaning_allowed[TOP] = (i == ySize - 1);
-                    result.push_back(layout);
+            if (stopRequested(i))
+                return;
+            for (size_t e = row_offsets[i]; e < row_offsets[i + 1]; ++e) {
+                change(events[e].x0, events[e].delta);
+                change(events[e].x1, -events[e].delta);
+            }
+
+            int coverage = 0;
+            size_t pos = 0;
+            for (auto& [x, delta] : diff) {
+                if (x >= xSize)
+                    break;
+                if (coverage == 0 && pos < x)
+                    intervals.push_back({ pos, x });
+                coverage += delta;
+                pos = x;
+            }
+            if (coverage == 0 && pos < xSize)
+                intervals.push_back({ pos, xSize });
+            interval_offsets.push_back(intervals.size());
+        }
+    }
+
+    bool AreasGrid::isFree(size_t row, size_t col) const {
+        if (!sparse)
+            return grid.test(row, col);
+        auto begin = intervals.begin() + interval_offsets[row];
+        auto end = intervals.begin() + interval_offsets[row + 1];
+        auto it = std::upper_bound(begin, end, col, [](size_t c, const FreeInterval& in) { return c < in.x0; });
+        return it != begin && col < std::prev(it)->x1;
+    }
+
+    AreaLayouts AreasGrid::calculateAllowedAreas(GridCalculationMode mode, LayoutAlignment align,
+        objects::Scalar min_width, objects::Scalar min_height) {
+        LayoutFilter filter{ align, min_width, min_height };
+        switch (mode) {
+        case GridCalculationMode::HORIZONTAL:
+            return calculateHorizontalAllowedAreas(filter);
+        case GridCalculationMode::HORIZONTAL_MERGED:
+            return calculateMergedAllowedAreas(filter);
+        }
+        return AreaLayouts(resource);
+    }
+
+    void AreasGrid::rowRuns(size_t row, std::pmr::vector<FreeInterval>& runs) const {
+        runs.clear();
+        if (sparse) {
+            runs.insert(runs.end(), intervals.begin() + interval_offsets[row], intervals.begin() + interval_offsets[row + 1]);
+            return;
+        }
+
+        auto xSize = grid.width();
+        for (size_t j0 = grid.findSet(row, 0); j0 < xSize; ) {
+            size_t j = grid.findClear(row, j0);
+            runs.push_back({ j0, j });
+            j0 = grid.findSet(row, j);
+        }
+    }
+
+    AreaLayouts AreasGrid::calculateHorizontalAllowedAreas(const LayoutFilter& filter) {
+        AreaLayouts result(resource);
+        std::pmr::vector<FreeInterval> runs(resource);
+        auto ySize = y_values.size() - 1;
+
+        for (size_t i = 0; i < ySize; ++i) {
+            if (stopRequested(i))
+                return result;
+            rowRuns(i, runs);
+            for (auto& r : runs)
+                addRunLayout(result, filter, r.x0, r.x1, i, i + 1);
+        }
+        return result;
+    }
+
+    AreaLayouts AreasGrid::calculateMergedAllowedAreas(const LayoutFilter& filter) {
+        AreaLayouts result(resource);
+        std::pmr::vector<FreeInterval> runs(resource);
+        auto ySize = y_values.size() - 1;
+
+        // Runs of the previous row which may still grow up, with the rows they start from.
+        // Both lists are sorted by columns, so they are matched with two pointers.
+        std::pmr::vector<FreeInterval> open_runs(resource), next_runs(resource);
+        std::pmr::vector<size_t> open_rows(resource), next_rows(resource);
+        for (size_t i = 0; i < ySize; ++i) {
+            if (stopRequested(i))
+                return result;
+            rowRuns(i, runs);
+            next_runs.clear();
+            next_rows.clear();
+
+            size_t k = 0;
+            for (auto& r : runs) {
+                for (; k < open_runs.size() && open_runs[k].x0 < r.x0; ++k)
+                    addRunLayout(result, filter, open_runs[k].x0, open_runs[k].x1, open_rows[k], i);
+
+                size_t start_row = i;
+                if (k < open_runs.size() && open_runs[k].x0 == r.x0) {
+                    if (open_runs[k].x1 == r.x1)
+                        start_row = open_rows[k];
+                    else
+                        addRunLayout(result, filter, open_runs[k].x0, open_runs[k].x1, open_rows[k], i);
+                    ++k;
                 }
+                next_runs.push_back(r);
+                next_rows.push_back(start_row);
             }
+            for (; k < open_runs.size(); ++k)
+                addRunLayout(result, filter, open_runs[k].x0, open_runs[k].x1, open_rows[k], i);
+
+            std::swap(open_runs, next_runs);
+            std::swap(open_rows, next_rows);
         }
+        for (size_t k = 0; k < open_runs.size(); ++k)
+            addRunLayout(result, filter, open_runs[k].x0, open_runs[k].x1, open_rows[k], ySize);
         return result;
     }
 
-    AreaLayout AreasGrid::createAreaLayout(size_t x0, size_t x, size_t y0, size_t y) {
-        objects::Point min_point = { x_values[x0], y_values[y0] };
-        double w = x_values[x] - x_values[x0];
-        double h = y_values[y] - y_values[y0];
+    void AreasGrid::addRunLayout(AreaLayouts& result, const LayoutFilter& filter, size_t x0, size_t x, size_t y0, size_t y) {
+        // Snapped grid lines are a range of values, free cells are taken without any of them,
+        // so that exclusion areas never shrink
+        AreaLayout area{ { x_max_values[x0], y_max_values[y0] } };
+        LayoutSpace space{ x_values[x] - x_max_values[x0], y_values[y] - y_max_values[y0] };
+
+        // A run is bounded by exclusion areas or the zone on the left and right in every row,
+        // only the zone borders are known to bound it from below and above
+        LayoutSides sides;
+        sides.setLeaningAllowed(LEFT, true);
+        sides.setLeaningAllowed(RIGHT, true);
+        sides.setLeaningAllowed(BOTTOM, y0 == 0);
+        sides.setLeaningAllowed(TOP, y == y_values.size() - 1);
 
-        return AreaLayout{min_point, w, h};
+        applyAlignment(space, sides, area, filter.align);
+        if (space.width < filter.min_width || space.height < filter.min_height)
+            return;
+        result.push_back(space, sides, area);
     }
 
     std::ostream& operator<< (std::ostream& out, const AreasGrid& a) {
@@ -100,9 +361,9 @@ namespace algo {
         out << "\n";
         auto xSize = a.x_values.size() - 1;
         auto ySize = a.y_values.size() - 1;
-        for (size_t i = ySize - 1; i >= 0; --i) {
+        for (size_t i = ySize; i-- > 0; ) {
             for (size_t j = 0; j < xSize; ++j)
-                out << a.grid[i * xSize + j] << " ";
+                out << a.isFree(i, j) << " ";
             out << "\n";
         }
         return out;
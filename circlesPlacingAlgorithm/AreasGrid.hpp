@@ -1,31 +1,100 @@
 #pragma once
 
+#include <cstddef>
 #include <iosfwd>
+#include <memory_resource>
 #include <vector>
 
 #include "objects.hpp"
 #include "AreaLayout.hpp"
+#include "BitGrid.hpp"
+#include "CancellationToken.hpp"
 
 
 namespace algo {
 	enum class GridCalculationMode{
-		HORIZONTAL
+		HORIZONTAL,         // a layout per free run of every row
+		HORIZONTAL_MERGED   // runs with the same columns in adjacent rows are merged into one taller layout
 	};
 
 	class AreasGrid {
     public:
-		AreasGrid(const objects::Rectangle& zone, const std::vector<objects::Rectangle>& exclusion_areas);
-		std::vector<AreaLayout> calculateAllowedAreas(GridCalculationMode mode, LayoutAlignment align = LayoutAlignment::NO_ALIGH);
+		// Dense grid size (bytes) from which free intervals rows are used instead
+		static constexpr size_t default_memory_budget = size_t{ 256 } << 20;
+
+		// threads - maximal number of threads used to fill big grids
+		// memory_budget - maximal size of the dense grid in bytes, sparse rows are built above it
+		// snap_epsilon - coordinates closer than it are merged into one grid line
+		// resource - memory of the grid and of the layouts it creates
+		// token - once it stops, the grid and the layouts are left incomplete, it has to outlive the grid
+		AreasGrid(const objects::Rectangle& zone, objects::ArrayView<objects::Rectangle> exclusion_areas, size_t threads = 1,
+			size_t memory_budget = default_memory_budget, objects::Scalar snap_epsilon = 0.0,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource(), const CancellationToken* token = nullptr);
+		// Layouts narrower than min_width or lower than min_height after the alignment are not created
+		AreaLayouts calculateAllowedAreas(GridCalculationMode mode, LayoutAlignment align = LayoutAlignment::NO_ALIGH,
+			objects::Scalar min_width = 0.0, objects::Scalar min_height = 0.0);
+
+		bool isSparse() const { return sparse; }
 
     private:
-        std::vector<bool> grid;
-        std::vector<double> x_values;
-        std::vector<double> y_values;
-
-		void fillCoordsValues(const objects::Rectangle& zone, const std::vector<objects::Rectangle>& exclusion_areas);
-		void fillGrid(const std::vector<objects::Rectangle>& exclusion_areas);
-		std::vector<AreaLayout> calculateHorizontalAllowedAreas();
-		AreaLayout createAreaLayout(size_t x0, size_t x, size_t y0, size_t y);
+        // Grid cells count from which filling is split between threads
+        static constexpr size_t parallel_fill_cells = size_t{ 1 } << 20;
+        // Rows between the token checks
+        static constexpr size_t stop_check_rows = 64;
+
+        // An exclusion area opening (delta = 1) or closing (delta = -1) on the row, covers columns [x0, x1)
+        struct GridEvent {
+            size_t x0;
+            size_t x1;
+            int delta;
+        };
+
+        struct LayoutFilter {
+            LayoutAlignment align;
+            objects::Scalar min_width;
+            objects::Scalar min_height;
+        };
+
+        // Free cells [x0, x1) of a sparse row
+        struct FreeInterval {
+            size_t x0;
+            size_t x1;
+        };
+
+        std::pmr::memory_resource* resource;
+        const CancellationToken* token{};
+        size_t threads{ 1 };
+        size_t memory_budget{ default_memory_budget };
+        objects::Scalar snap_epsilon{ 0.0 };
+        bool sparse{ false };
+        // Dense representation, one bit per cell, set for free cells
+        BitGrid grid;
+        // Sparse representation, free intervals of row i are intervals[interval_offsets[i], interval_offsets[i + 1])
+        std::pmr::vector<size_t> interval_offsets;
+        std::pmr::vector<FreeInterval> intervals;
+        std::pmr::vector<objects::Scalar> x_values;
+        std::pmr::vector<objects::Scalar> y_values;
+        // The biggest coordinates snapped to the grid lines, equal to x_values/y_values without snapping
+        std::pmr::vector<objects::Scalar> x_max_values;
+        std::pmr::vector<objects::Scalar> y_max_values;
+
+		void fillCoordsValues(const objects::Rectangle& zone, objects::ArrayView<objects::Rectangle> exclusion_areas);
+		void snapValues(std::pmr::vector<objects::Scalar>& values, std::pmr::vector<objects::Scalar>& max_values) const;
+		// coord - the coordinate of the lines, x or y
+		void splitCollapsedLines(objects::ArrayView<objects::Rectangle> exclusion_areas, objects::Scalar objects::Point::* coord,
+			std::pmr::vector<objects::Scalar>& values, std::pmr::vector<objects::Scalar>& max_values) const;
+		static size_t snappedIndex(const std::pmr::vector<objects::Scalar>& values, objects::Scalar value);
+		void fillGrid(objects::ArrayView<objects::Rectangle> exclusion_areas);
+		// buffers - memory of the row buffers, the bands filled by other threads can't share it
+		void fillRows(size_t row_begin, size_t row_end, const std::pmr::vector<size_t>& row_offsets,
+			const std::pmr::vector<GridEvent>& events, std::pmr::memory_resource* buffers);
+		void fillIntervals(const std::pmr::vector<size_t>& row_offsets, const std::pmr::vector<GridEvent>& events);
+		bool stopRequested(size_t row) const { return token && row % stop_check_rows == 0 && token->stopRequested(); }
+		bool isFree(size_t row, size_t col) const;
+		void rowRuns(size_t row, std::pmr::vector<FreeInterval>& runs) const;
+		AreaLayouts calculateHorizontalAllowedAreas(const LayoutFilter& filter);
+		AreaLayouts calculateMergedAllowedAreas(const LayoutFilter& filter);
+		void addRunLayout(AreaLayouts& result, const LayoutFilter& filter, size_t x0, size_t x, size_t y0, size_t y);
 
 
 		friend std::ostream& operator<< (std::ostream& out, const AreasGrid& a);
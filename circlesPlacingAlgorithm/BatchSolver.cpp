@@ -0,0 +1,88 @@
+#include "BatchSolver.hpp"
+
+#include <algorithm>
+
+namespace algo {
+    BatchSolver::BatchSolver(const AlgorithmSettings& settings, size_t threads) {
+        if (threads == 0)
+            threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        for (size_t i = 0; i < threads; ++i)
+            algorithms.push_back(std::make_unique<GridBasedAlgorithm>(settings));
+        try {
+            for (size_t i = 0; i < threads; ++i)
+                workers.emplace_back(&BatchSolver::work, this, i);
+        } catch (...) {
+            // Joinable threads can't be destroyed, the started workers are stopped first
+            stop();
+            throw;
+        }
+    }
+
+    BatchSolver::~BatchSolver() {
+        stop();
+    }
+
+    void BatchSolver::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        batch_started.notify_all();
+        for (auto& w : workers)
+            w.join();
+    }
+
+    std::vector<std::optional<objects::ResultData>> BatchSolver::solve(objects::ArrayView<objects::SceneView> batch_scenes) {
+        std::lock_guard<std::mutex> batch_lock(batch_mutex);
+        std::vector<std::optional<objects::ResultData>> batch_results(batch_scenes.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            scenes = batch_scenes;
+            results = &batch_results;
+            next_scene = 0;
+            error = nullptr;
+            busy_workers = workers.size();
+            batch++;
+        }
+        batch_started.notify_all();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        batch_finished.wait(lock, [this] { return busy_workers == 0; });
+        if (error)
+            std::rethrow_exception(error);
+        return batch_results;
+    }
+
+    std::vector<std::optional<objects::ResultData>> BatchSolver::solve(const std::vector<objects::Scene>& batch_scenes) {
+        std::vector<objects::SceneView> views(batch_scenes.begin(), batch_scenes.end());
+        return solve(objects::ArrayView<objects::SceneView>(views));
+    }
+
+    void BatchSolver::work(size_t worker) {
+        size_t done_batch = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                batch_started.wait(lock, [&] { return stopping || batch != done_batch; });
+                if (stopping)
+                    return;
+                done_batch = batch;
+            }
+
+            // Scenes are taken one by one, so big scenes don't leave the other workers idle
+            for (size_t i = next_scene++; i < scenes.size(); i = next_scene++) {
+                try {
+                    (*results)[i] = algorithms[worker]->calculate(scenes[i]);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy_workers == 0)
+                batch_finished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Algorithm.hpp"
+#include "objects.hpp"
+
+namespace algo {
+    // Solves lists of scenes on a fixed pool of threads. Every worker owns a GridBasedAlgorithm, so its memory
+    // is reused by the scenes the worker solves. Batches of concurrent callers are solved one after another.
+    class BatchSolver {
+    public:
+        // threads - pool size, the hardware threads count by default
+        explicit BatchSolver(const AlgorithmSettings& settings = {}, size_t threads = 0);
+        BatchSolver(const BatchSolver&) = delete;
+        BatchSolver& operator=(const BatchSolver&) = delete;
+        ~BatchSolver();
+
+        size_t threadsCount() const { return workers.size(); }
+
+        // Results in the scenes order, nullopt for the scenes which can't be solved.
+        // An exception thrown by a solve is rethrown once the whole batch is done.
+        std::vector<std::optional<objects::ResultData>> solve(objects::ArrayView<objects::SceneView> scenes);
+        std::vector<std::optional<objects::ResultData>> solve(const std::vector<objects::Scene>& scenes);
+
+    private:
+        std::vector<std::unique_ptr<GridBasedAlgorithm>> algorithms;
+        std::vector<std::thread> workers;
+
+        std::mutex batch_mutex;
+        std::mutex mutex;
+        std::condition_variable batch_started;
+        std::condition_variable batch_finished;
+        // Current batch, guarded by mutex except next_scene
+        objects::ArrayView<objects::SceneView> scenes;
+        std::vector<std::optional<objects::ResultData>>* results{};
+        std::atomic<size_t> next_scene{};
+        size_t batch{};
+        size_t busy_workers{};
+        std::exception_ptr error;
+        bool stopping{};
+
+        void work(size_t worker);
+        void stop();
+    };
+}
@@ -0,0 +1,117 @@
+#include "BitGrid.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITGRID_SSE2
+#endif
+
+namespace algo {
+    namespace {
+        // x must be non zero
+        size_t countTrailingZeros(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+            unsigned long ind;
+            _BitScanForward64(&ind, x);
+            return ind;
+#elif defined(_MSC_VER)
+            unsigned long ind;
+            if (_BitScanForward(&ind, static_cast<unsigned long>(x)))
+                return ind;
+            _BitScanForward(&ind, static_cast<unsigned long>(x >> 32));
+            return ind + 32;
+#else
+            return __builtin_ctzll(x);
+#endif
+        }
+
+        uint64_t lowMask(size_t bits) {
+            return bits >= 64 ? ~uint64_t{} : (uint64_t{ 1 } << bits) - 1;
+        }
+
+        // Index of the first word in [begin, end) which is not equal to skip, end if there is none.
+        // Long uniform rows are skipped several words at a time.
+        size_t skipWords(const uint64_t* data, size_t begin, size_t end, uint64_t skip) {
+            size_t i = begin;
+#if defined(__AVX2__)
+            const __m256i pattern = _mm256_set1_epi64x(static_cast<long long>(skip));
+            for (; i + 4 <= end; i += 4) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(block, pattern)) != -1)
+                    break;
+            }
+#elif defined(BITGRID_SSE2)
+            // 32-bit lanes are enough as only the equality of whole words is checked
+            const __m128i pattern = _mm_set1_epi32(static_cast<int>(skip));
+            for (; i + 2 <= end; i += 2) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(block, pattern)) != 0xFFFF)
+                    break;
+            }
+#endif
+            while (i < end && data[i] == skip)
+                ++i;
+            return i;
+        }
+    }
+
+    BitGrid::BitGrid(size_t width, size_t height, bool value, std::pmr::memory_resource* resource) :
+        cols{ width }, rows{ height }, row_words{ (width + 63) / 64 }, words{ resource } {
+        words.assign(rows * row_words, 0);
+        if (value) {
+            for (size_t i = 0; i < rows; ++i)
+                setRange(i, 0, cols, true);
+        }
+    }
+
+    void BitGrid::setRange(size_t row, size_t from, size_t to, bool value) {
+        if (from >= to)
+            return;
+
+        uint64_t* data = rowData(row);
+        size_t first = from / 64;
+        size_t last = (to - 1) / 64;
+        for (size_t w = first; w <= last; ++w) {
+            uint64_t mask = ~uint64_t{};
+            if (w == first)
+                mask &= ~lowMask(from % 64);
+            if (w == last)
+                mask &= lowMask(to - last * 64);
+
+            if (value)
+                data[w] |= mask;
+            else
+                data[w] &= ~mask;
+        }
+    }
+
+    size_t BitGrid::findSet(size_t row, size_t col) const {
+        return find(row, col, 0);
+    }
+
+    size_t BitGrid::findClear(size_t row, size_t col) const {
+        return find(row, col, ~uint64_t{});
+    }
+
+    size_t BitGrid::find(size_t row, size_t col, uint64_t invert) const {
+        if (col >= cols)
+            return cols;
+
+        const uint64_t* data = rowData(row);
+        size_t w = col / 64;
+        uint64_t word = (data[w] ^ invert) & ~lowMask(col % 64);
+        if (!word) {
+            w = skipWords(data, w + 1, row_words, invert);
+            if (w == row_words)
+                return cols;
+            word = data[w] ^ invert;
+        }
+
+        size_t result = w * 64 + countTrailingZeros(word);
+        return result < cols ? result : cols;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace algo {
+    // Row-major bit matrix packed in 64-bit words, every row starts at a word boundary.
+    // Bits past the row width are kept cleared.
+    class BitGrid {
+    public:
+        BitGrid() = default;
+        explicit BitGrid(std::pmr::memory_resource* resource) : words{ resource } {}
+        BitGrid(size_t width, size_t height, bool value, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        size_t width() const { return cols; }
+        size_t height() const { return rows; }
+        size_t wordsPerRow() const { return row_words; }
+
+        bool test(size_t row, size_t col) const {
+            return (words[row * row_words + col / 64] >> (col % 64)) & 1;
+        }
+        // Sets bits [from, to) of the row
+        void setRange(size_t row, size_t from, size_t to, bool value);
+
+        // Index of the first set / cleared bit of the row at or after col, width() if there is none
+        size_t findSet(size_t row, size_t col) const;
+        size_t findClear(size_t row, size_t col) const;
+
+        uint64_t* rowData(size_t row) { return words.data() + row * row_words; }
+        const uint64_t* rowData(size_t row) const { return words.data() + row * row_words; }
+
+    private:
+        size_t cols{};
+        size_t rows{};
+        size_t row_words{};
+        std::pmr::vector<uint64_t> words;
+
+        size_t find(size_t row, size_t col, uint64_t invert) const;
+    };
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+
+namespace algo {
+    // Stops a running solve when it is cancelled from another thread or when its deadline passes.
+    // A stopped token stays stopped, it can be shared by several solves.
+    class CancellationToken {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        CancellationToken() = default;
+        explicit CancellationToken(Clock::time_point deadline) : deadline{ deadline } {}
+        explicit CancellationToken(Clock::duration timeout) : deadline{ Clock::now() + timeout } {}
+        CancellationToken(const CancellationToken&) = delete;
+        CancellationToken& operator=(const CancellationToken&) = delete;
+
+        void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+        bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+        bool isExpired() const { return deadline && Clock::now() >= *deadline; }
+        bool stopRequested() const { return isCancelled() || isExpired(); }
+
+    private:
+        std::atomic<bool> cancelled{};
+        std::optional<Clock::time_point> deadline;
+    };
+}
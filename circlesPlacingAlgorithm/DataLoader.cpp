@@ -18,15 +18,29 @@ namespace dataloader {
         auto zoneNode = doc.select_node(xmlAttributes::zonePath).node();
         objects::Scene scene(loadRectangle(zoneNode));
 
+        // Records are read as raw values and validated in bulk, so that incorrect ones are reported at once
         auto alarmsNodes = doc.select_nodes(xmlAttributes::alarmsPath);
+        std::vector<objects::Point> minPoints, maxPoints;
+        minPoints.reserve(alarmsNodes.size());
+        maxPoints.reserve(alarmsNodes.size());
         for (pugi::xpath_node_set::const_iterator it = alarmsNodes.begin(); it != alarmsNodes.end(); ++it) {
-            scene.addExclusionArea(loadRectangle(it->node()));
+            minPoints.push_back(loadPoint(it->node().child(xmlAttributes::minPoint)));
+            maxPoints.push_back(loadPoint(it->node().child(xmlAttributes::maxPoint)));
         }
+        checkErrors(scene.addExclusionAreas(minPoints, maxPoints), "exclusion areas");
 
         auto circlesNodes = doc.select_nodes(xmlAttributes::circlesPath);
+        std::vector<int> ids;
+        std::vector<objects::Scalar> inRads, outRads;
+        ids.reserve(circlesNodes.size());
+        inRads.reserve(circlesNodes.size());
+        outRads.reserve(circlesNodes.size());
         for (pugi::xpath_node_set::const_iterator it = circlesNodes.begin(); it != circlesNodes.end(); ++it) {
-            scene.addCircle(loadCircle(it->node()));
+            ids.push_back(loadAttribute(it->node(), xmlAttributes::id).as_int());
+            inRads.push_back(static_cast<objects::Scalar>(loadAttribute(it->node(), xmlAttributes::inRad).as_double()));
+            outRads.push_back(static_cast<objects::Scalar>(loadAttribute(it->node(), xmlAttributes::outRad).as_double()));
         }
+        checkErrors(scene.addCircles(ids, inRads, outRads), "circles");
 
         return scene;
     }
@@ -38,11 +52,12 @@ namespace dataloader {
         for (size_t i = 1; i < xmlAttributes::resultStr.size() - 1; ++i) {
             node = node.append_child(xmlAttributes::resultStr[i]);
         }
-        for (auto& c : results.circles) {
+        auto& circles = results.circles;
+        for (size_t i = 0; i < circles.size(); ++i) {
             pugi::xml_node circle = node.append_child(xmlAttributes::resultStr.back());
-            circle.append_attribute(xmlAttributes::id).set_value(c.getId());
-            circle.append_attribute(xmlAttributes::x).set_value(c.position.x);
-            circle.append_attribute(xmlAttributes::y).set_value(c.position.y);
+            circle.append_attribute(xmlAttributes::id).set_value(circles.getId(i));
+            circle.append_attribute(xmlAttributes::x).set_value(circles.getXs()[i]);
+            circle.append_attribute(xmlAttributes::y).set_value(circles.getYs()[i]);
         }
 
         if (!doc.save_file(path))
@@ -50,18 +65,21 @@ namespace dataloader {
     }
 
     objects::Rectangle XmlDataLoader::loadRectangle(const pugi::xml_node& node) {
-        double minX = loadAttribute(node.child(xmlAttributes::minPoint), xmlAttributes::x).as_double();
-        double minY = loadAttribute(node.child(xmlAttributes::minPoint), xmlAttributes::y).as_double();
-        double maxX = loadAttribute(node.child(xmlAttributes::maxPoint), xmlAttributes::x).as_double();
-        double maxY = loadAttribute(node.child(xmlAttributes::maxPoint), xmlAttributes::y).as_double();
-        return objects::Rectangle{ {minX, minY}, {maxX, maxY} };
+        return objects::Rectangle{ loadPoint(node.child(xmlAttributes::minPoint)), loadPoint(node.child(xmlAttributes::maxPoint)) };
     }
 
-    objects::Circle XmlDataLoader::loadCircle(const pugi::xml_node& node) {
-        int id = loadAttribute(node, xmlAttributes::id).as_int();
-        double inRad = loadAttribute(node, xmlAttributes::inRad).as_double();
-        double outRad = loadAttribute(node, xmlAttributes::outRad).as_double();
-        return objects::Circle{ id, inRad, outRad };
+    objects::Point XmlDataLoader::loadPoint(const pugi::xml_node& node) {
+        auto x = static_cast<objects::Scalar>(loadAttribute(node, xmlAttributes::x).as_double());
+        auto y = static_cast<objects::Scalar>(loadAttribute(node, xmlAttributes::y).as_double());
+        return { x, y };
+    }
+
+    void XmlDataLoader::checkErrors(const objects::ValidationErrors& errors, const char* records) {
+        if (errors.empty())
+            return;
+        auto& first = errors.front();
+        throw objects::ObjectConstructionException(std::to_string(errors.size()) + " incorrect " + records +
+            ", first one #" + std::to_string(first.index) + ": " + objects::errorMessage(first.error));
     }
 
     pugi::xml_attribute XmlDataLoader::loadAttribute(const pugi::xml_node& node, const char* attributeName) {
@@ -31,7 +31,9 @@ namespace dataloader {
 
     private:
         objects::Rectangle loadRectangle(const pugi::xml_node& node);
-        objects::Circle loadCircle(const pugi::xml_node& node);
+        objects::Point loadPoint(const pugi::xml_node& node);
+        // Throws an exception describing the records rejected by a bulk validation, if any
+        void checkErrors(const objects::ValidationErrors& errors, const char* records);
         pugi::xml_attribute loadAttribute(const pugi::xml_node& node, const char* attributeName);
     };
 
@@ -74,17 +74,19 @@ namespace imagecreator {
             g.FillRectangle(&brush, x0 + offset, y0 + offset, x, y);
             g.DrawRectangle(&pen, x0 + offset, y0 + offset, x, y);
         }
-        for (auto& c : results.circles) {
-            double outRad = c.outRad();
-            double inRad = c.inRad();
-            Gdiplus::REAL x = (c.position.x - scene.getZone().minPoint().x - outRad) * scale;
-            Gdiplus::REAL y = (scene.getZone().maxPoint().y - c.position.y - outRad) * scale;
+        auto& circles = results.circles;
+        for (size_t i = 0; i < circles.size(); ++i) {
+            double outRad = circles.outRad(i);
+            double inRad = circles.inRad(i);
+            objects::Point position = circles.position(i);
+            Gdiplus::REAL x = (position.x - scene.getZone().minPoint().x - outRad) * scale;
+            Gdiplus::REAL y = (scene.getZone().maxPoint().y - position.y - outRad) * scale;
             Gdiplus::REAL r = outRad * 2.0 * scale;
             g.DrawEllipse(&pen, x + offset, y + offset, r, r);
             g.FillEllipse(&weak_brush, x + offset, y + offset, r, r);
 
-            Gdiplus::REAL x0 = (c.position.x - scene.getZone().minPoint().x - inRad) * scale;
-            Gdiplus::REAL y0 = (scene.getZone().maxPoint().y - c.position.y - inRad) * scale;
+            Gdiplus::REAL x0 = (position.x - scene.getZone().minPoint().x - inRad) * scale;
+            Gdiplus::REAL y0 = (scene.getZone().maxPoint().y - position.y - inRad) * scale;
             Gdiplus::REAL r0 = inRad * 2.0 * scale;
             g.DrawEllipse(&pen, x0 + offset, y0 + offset, r0, r0);
         }
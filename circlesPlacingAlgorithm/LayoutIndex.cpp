@@ -0,0 +1,198 @@
+#include "LayoutIndex.hpp"
+
+#include <algorithm>
+
+namespace algo {
+    LayoutIndex::LayoutIndex(const std::pmr::vector<LayoutSpace>& spaces, const std::pmr::vector<LayoutSides>& sides,
+        std::pmr::memory_resource* resource) :
+        tree(resource), ids(resource), active(resource) {
+        ids.reserve(spaces.size());
+        active.reserve(spaces.size());
+        rebuild(std::max<size_t>(spaces.size(), 1));
+        for (size_t i = 0; i < spaces.size(); ++i) {
+            tree[capacity + count++] = createKeys(spaces[i], sides[i]);
+            ids.push_back(next_id++);
+            active.push_back(true);
+        }
+        for (size_t i = capacity - 1; i > 0; --i)
+            tree[i] = merge(tree[2 * i], tree[2 * i + 1]);
+    }
+
+    size_t LayoutIndex::position(size_t layout_ind) const {
+        return std::distance(ids.begin(), std::lower_bound(ids.begin(), ids.end(), layout_ind));
+    }
+
+    void LayoutIndex::setMinInRad(objects::Scalar rad) {
+        min_in_rad = rad;
+    }
+
+    void LayoutIndex::update(size_t pos, const LayoutSpace& space, LayoutSides sides) {
+        if (!active[pos])
+            return;
+
+        auto keys = createKeys(space, sides);
+        if (usable(keys))
+            set(pos, keys);
+        else
+            retire(pos);
+    }
+
+    void LayoutIndex::push_back(const LayoutSpace& space, LayoutSides sides) {
+        if (count == capacity)
+            rebuild(capacity * 2);
+        ids.push_back(next_id++);
+        active.push_back(true);
+        update(count++, space, sides);
+    }
+
+    size_t LayoutIndex::findFirst(size_t from, size_t to, objects::Scalar inRad, objects::Scalar outRad) const {
+        if (from >= std::min(to, count))
+            return npos;
+
+        // The round-robin traversal mostly stays on the same layout, so the leaf is checked before the descent
+        auto q = createQuery(inRad, outRad);
+        if (suitable(tree[capacity + from], q))
+            return from;
+        return findFirst(1, 0, capacity, from, std::min(to, count), q);
+    }
+
+    size_t LayoutIndex::findLast(size_t from, size_t to, objects::Scalar inRad, objects::Scalar outRad) const {
+        if (from >= std::min(to, count))
+            return npos;
+        return findLast(1, 0, capacity, from, std::min(to, count), createQuery(inRad, outRad));
+    }
+
+    LayoutIndex::Keys LayoutIndex::createKeys(const LayoutSpace& space, LayoutSides sides) {
+        Keys keys;
+        int left = sides.leaningAllowed(LEFT);
+        int right = sides.leaningAllowed(RIGHT);
+        int bottom = sides.leaningAllowed(BOTTOM);
+        int top = sides.leaningAllowed(TOP);
+        keys.width[left + right] = space.width;
+        if (space.empty())
+            keys.free_height[bottom + top] = space.height;
+        else
+            keys.free_height[top] = space.height - space.filled_height;
+
+        // Split off layout is empty and keeps the bottom and top sides of the original one
+        keys.split_height[bottom + top] = space.height;
+        keys.free_width = space.width - space.filled_width;
+        return keys;
+    }
+
+    LayoutIndex::Keys LayoutIndex::merge(const Keys& a, const Keys& b) {
+        Keys keys;
+        for (size_t i = 0; i < 3; ++i) {
+            keys.width[i] = std::max(a.width[i], b.width[i]);
+            keys.free_height[i] = std::max(a.free_height[i], b.free_height[i]);
+            keys.split_height[i] = std::max(a.split_height[i], b.split_height[i]);
+        }
+        keys.free_width = std::max(a.free_width, b.free_width);
+        return keys;
+    }
+
+    LayoutIndex::Query LayoutIndex::createQuery(objects::Scalar inRad, objects::Scalar outRad) {
+        // Keys are compared with a small tolerance so that the index never rejects a layout
+        // which passes the exact check because of a different rounding. Single precision needs a wider one.
+        constexpr objects::Scalar tolerance = std::max(static_cast<objects::Scalar>(1e-9),
+            std::numeric_limits<objects::Scalar>::epsilon() * 64);
+
+        Query q;
+        for (size_t i = 0; i < 3; ++i) {
+            objects::Scalar needed = i * inRad + (2 - i) * outRad;
+            q.needed[i] = needed - needed * tolerance;
+        }
+        q.split_width = outRad * 2;
+        return q;
+    }
+
+    bool LayoutIndex::usable(const Keys& keys) const {
+        // Requirements grow with both radiuses, so the smallest possible circle is the one with
+        // inner and outer radiuses equal to the minimal inner radius
+        return suitable(keys, createQuery(min_in_rad, min_in_rad));
+    }
+
+    bool LayoutIndex::suitable(const Keys& keys, const Query& q) {
+        auto satisfies = [&q](const std::array<objects::Scalar, 3>& values) {
+            return values[0] >= q.needed[0] || values[1] >= q.needed[1] || values[2] >= q.needed[2];
+        };
+
+        bool fits = satisfies(keys.width) && satisfies(keys.free_height);
+        bool splits = keys.free_width > q.split_width && satisfies(keys.split_height);
+        return fits || splits;
+    }
+
+    void LayoutIndex::rebuild(size_t new_capacity) {
+        capacity = 1;
+        while (capacity < new_capacity)
+            capacity *= 2;
+
+        std::pmr::vector<Keys> new_tree(capacity * 2, tree.get_allocator());
+        for (size_t i = 0; i < count; ++i)
+            new_tree[capacity + i] = tree[tree.size() / 2 + i];
+        tree = std::move(new_tree);
+        for (size_t i = capacity - 1; i > 0; --i)
+            tree[i] = merge(tree[2 * i], tree[2 * i + 1]);
+    }
+
+    void LayoutIndex::retire(size_t pos) {
+        set(pos, Keys{});
+        active[pos] = false;
+        // Compaction is linear, so it is done only when it at least halves the tree
+        if (++retired * 2 > count)
+            compact();
+    }
+
+    void LayoutIndex::compact() {
+        size_t new_count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (active[i]) {
+                tree[capacity + new_count] = tree[capacity + i];
+                ids[new_count] = ids[i];
+                new_count++;
+            }
+        }
+        count = new_count;
+        retired = 0;
+        ids.resize(count);
+        active.assign(count, true);
+        rebuild(std::max<size_t>(count, 1));
+    }
+
+    void LayoutIndex::set(size_t pos, const Keys& keys) {
+        size_t node = capacity + pos;
+        tree[node] = keys;
+        for (node /= 2; node > 0; node /= 2) {
+            auto merged = merge(tree[2 * node], tree[2 * node + 1]);
+            if (merged == tree[node])
+                break;
+            tree[node] = merged;
+        }
+    }
+
+    size_t LayoutIndex::findFirst(size_t node, size_t lo, size_t hi, size_t from, size_t to, const Query& q) const {
+        if (hi <= from || to <= lo || !suitable(tree[node], q))
+            return npos;
+        if (hi - lo == 1)
+            return lo;
+
+        size_t mid = (lo + hi) / 2;
+        size_t pos = findFirst(2 * node, lo, mid, from, to, q);
+        if (pos == npos)
+            pos = findFirst(2 * node + 1, mid, hi, from, to, q);
+        return pos;
+    }
+
+    size_t LayoutIndex::findLast(size_t node, size_t lo, size_t hi, size_t from, size_t to, const Query& q) const {
+        if (hi <= from || to <= lo || !suitable(tree[node], q))
+            return npos;
+        if (hi - lo == 1)
+            return lo;
+
+        size_t mid = (lo + hi) / 2;
+        size_t pos = findLast(2 * node + 1, mid, hi, from, to, q);
+        if (pos == npos)
+            pos = findLast(2 * node, lo, mid, from, to, q);
+        return pos;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+#include "AreaLayout.hpp"
+
+namespace algo {
+    // Segment tree over layouts positions which answers "which layout can take a circle with given radiuses"
+    // in logarithmic time instead of a linear scan.
+    // The placement requirements of a layout are linear in the circle radiuses: every side either allows
+    // leaning (inner radius is enough) or not (outer radius is needed). So the keys are grouped by
+    // the number of leaning sides, which makes the check exact in a leaf and conservative in inner nodes.
+    // Layouts which can't take any of the remaining circles are retired, and once retired ones outnumber
+    // the active ones the tree is compacted, so positions are not layouts indices: use layout() / position().
+    class LayoutIndex {
+    public:
+        static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+        LayoutIndex() = default;
+        LayoutIndex(const std::pmr::vector<LayoutSpace>& spaces, const std::pmr::vector<LayoutSides>& sides,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        size_t size() const { return count; }
+        size_t layout(size_t pos) const { return ids[pos]; }
+        // Position of the first layout with index not less than layout_ind
+        size_t position(size_t layout_ind) const;
+
+        // Layouts which can't take a circle with inner radius min_in_rad are retired on update
+        void setMinInRad(objects::Scalar min_in_rad);
+
+        void update(size_t pos, const LayoutSpace& space, LayoutSides sides);
+        void push_back(const LayoutSpace& space, LayoutSides sides);
+
+        // First / last position in [from, to) where the circle fits in the layout or the layout can be split for it
+        size_t findFirst(size_t from, size_t to, objects::Scalar inRad, objects::Scalar outRad) const;
+        size_t findLast(size_t from, size_t to, objects::Scalar inRad, objects::Scalar outRad) const;
+
+    private:
+        static constexpr objects::Scalar none = -std::numeric_limits<objects::Scalar>::infinity();
+
+        // Index of every array is the number of sides which allow leaning
+        struct Keys {
+            std::array<objects::Scalar, 3> width{ none, none, none };
+            std::array<objects::Scalar, 3> free_height{ none, none, none };
+            std::array<objects::Scalar, 3> split_height{ none, none, none };
+            objects::Scalar free_width{ none };
+
+            bool operator==(const Keys& other) const {
+                return width == other.width && free_height == other.free_height &&
+                    split_height == other.split_height && free_width == other.free_width;
+            }
+        };
+
+        struct Query {
+            std::array<objects::Scalar, 3> needed;
+            objects::Scalar split_width;
+        };
+
+        size_t count{};
+        size_t capacity{};
+        size_t retired{};
+        size_t next_id{};
+        objects::Scalar min_in_rad{};
+        std::pmr::vector<Keys> tree;
+        std::pmr::vector<size_t> ids;
+        std::pmr::vector<bool> active;
+
+        static Keys createKeys(const LayoutSpace& space, LayoutSides sides);
+        static Keys merge(const Keys& a, const Keys& b);
+        static Query createQuery(objects::Scalar inRad, objects::Scalar outRad);
+        static bool suitable(const Keys& keys, const Query& q);
+
+        bool usable(const Keys& keys) const;
+
+        void rebuild(size_t new_capacity);
+        void retire(size_t pos);
+        void compact();
+        void set(size_t pos, const Keys& keys);
+        size_t findFirst(size_t node, size_t lo, size_t hi, size_t from, size_t to, const Query& q) const;
+        size_t findLast(size_t node, size_t lo, size_t hi, size_t from, size_t to, const Query& q) const;
+    };
+}
@@ -0,0 +1,92 @@
+#include "PlacementCheck.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace algo {
+    size_t countPlacementViolations(const objects::SceneView& scene, const objects::ResultData& result, double tolerance,
+        std::pmr::memory_resource* resource) {
+        auto& circles = result.circles;
+        size_t n = circles.size();
+        if (n == 0)
+            return 0;
+
+        double min_x = scene.getZone().minPoint().x, min_y = scene.getZone().minPoint().y;
+        double max_x = scene.getZone().maxPoint().x, max_y = scene.getZone().maxPoint().y;
+        // Circles leaving the zone or entering an area, every one is counted once
+        std::pmr::vector<bool> misplaced(n, false, resource);
+        for (size_t i = 0; i < n; ++i) {
+            double x = circles.getXs()[i], y = circles.getYs()[i], r = circles.inRad(i) - tolerance;
+            misplaced[i] = (x - r < min_x) | (x + r > max_x) | (y - r < min_y) | (y + r > max_y);
+        }
+
+        // Circles are bucketed into square cells not narrower than the biggest diameter, so overlapping circles
+        // lie in neighbouring cells. Cells are coarsened until there are not many more of them than circles.
+        auto& out_rads = circles.getOutRads();
+        double cell = 2.0 * *std::max_element(out_rads.begin(), out_rads.end());
+        size_t cols, rows;
+        for (;; cell *= 2) {
+            cols = static_cast<size_t>((max_x - min_x) / cell) + 1;
+            rows = static_cast<size_t>((max_y - min_y) / cell) + 1;
+            if (cols * rows <= 4 * n + 16)
+                break;
+        }
+        auto cellOf = [&](double value, double origin, size_t count) {
+            double pos = std::floor((value - origin) / cell);
+            return static_cast<size_t>(std::clamp(pos, 0.0, static_cast<double>(count - 1)));
+        };
+
+        std::pmr::vector<size_t> circle_cells(n, resource);
+        std::pmr::vector<size_t> offsets(cols * rows + 1, 0, resource);
+        for (size_t i = 0; i < n; ++i) {
+            circle_cells[i] = cellOf(circles.getYs()[i], min_y, rows) * cols + cellOf(circles.getXs()[i], min_x, cols);
+            offsets[circle_cells[i] + 1]++;
+        }
+        for (size_t c = 0; c < cols * rows; ++c)
+            offsets[c + 1] += offsets[c];
+        std::pmr::vector<size_t> next(offsets.begin(), offsets.end() - 1, resource);
+        std::pmr::vector<size_t> bucketed(n, resource);
+        for (size_t i = 0; i < n; ++i)
+            bucketed[next[circle_cells[i]]++] = i;
+
+        // A circle entering an area has its center in a cell the area covers or in a neighbouring one
+        for (auto& area : scene.getExclusionAreas()) {
+            double x0 = area.minPoint().x, y0 = area.minPoint().y, x1 = area.maxPoint().x, y1 = area.maxPoint().y;
+            size_t col0 = cellOf(x0, min_x, cols), col1 = cellOf(x1, min_x, cols);
+            size_t row0 = cellOf(y0, min_y, rows), row1 = cellOf(y1, min_y, rows);
+            for (size_t r = (row0 > 0 ? row0 - 1 : 0); r <= std::min(row1 + 1, rows - 1); ++r) {
+                for (size_t c = (col0 > 0 ? col0 - 1 : 0); c <= std::min(col1 + 1, cols - 1); ++c) {
+                    size_t bucket = r * cols + c;
+                    for (size_t k = offsets[bucket]; k < offsets[bucket + 1]; ++k) {
+                        size_t i = bucketed[k];
+                        double x = circles.getXs()[i], y = circles.getYs()[i], rad = circles.inRad(i) - tolerance;
+                        double dx = std::max({ x0 - x, 0.0, x - x1 }), dy = std::max({ y0 - y, 0.0, y - y1 });
+                        if (rad > 0 && dx * dx + dy * dy < rad * rad)
+                            misplaced[i] = true;
+                    }
+                }
+            }
+        }
+        size_t violations = std::count(misplaced.begin(), misplaced.end(), true);
+
+        for (size_t i = 0; i < n; ++i) {
+            size_t row = circle_cells[i] / cols, col = circle_cells[i] % cols;
+            double x = circles.getXs()[i], y = circles.getYs()[i];
+            for (size_t r = (row > 0 ? row - 1 : 0); r <= std::min(row + 1, rows - 1); ++r) {
+                for (size_t c = (col > 0 ? col - 1 : 0); c <= std::min(col + 1, cols - 1); ++c) {
+                    size_t bucket = r * cols + c;
+                    for (size_t k = offsets[bucket]; k < offsets[bucket + 1]; ++k) {
+                        size_t j = bucketed[k];
+                        if (j <= i)
+                            continue;
+                        double dx = x - circles.getXs()[j], dy = y - circles.getYs()[j];
+                        double min_distance = static_cast<double>(circles.outRad(i)) + circles.outRad(j) - tolerance;
+                        violations += (min_distance > 0 && dx * dx + dy * dy < min_distance * min_distance);
+                    }
+                }
+            }
+        }
+        return violations;
+    }
+}
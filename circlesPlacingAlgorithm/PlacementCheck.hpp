@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "objects.hpp"
+
+namespace algo {
+    // Number of circles leaving the zone or entering an exclusion area and of overlapping circles pairs of the result,
+    // all by more than tolerance. Inner circles have to stay inside the zone and out of the exclusion areas, outer circles
+    // must not overlap. Distances are computed in double precision, so single precision results are checked against
+    // their exact positions.
+    size_t countPlacementViolations(const objects::SceneView& scene, const objects::ResultData& result, double tolerance,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+}
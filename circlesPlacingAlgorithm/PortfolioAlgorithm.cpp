@@ -0,0 +1,102 @@
+#include "PortfolioAlgorithm.hpp"
+
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace algo {
+    std::vector<PortfolioVariant> defaultPortfolio(const AlgorithmSettings& settings) {
+        std::vector<PortfolioVariant> variants{ { settings.grid_mode, settings.alignment } };
+        for (auto mode : { GridCalculationMode::HORIZONTAL, GridCalculationMode::HORIZONTAL_MERGED }) {
+            for (auto alignment : { LayoutAlignment::WIDTH_LESS, LayoutAlignment::HEIGHT_LESS, LayoutAlignment::NO_ALIGH }) {
+                if (mode != settings.grid_mode || alignment != settings.alignment)
+                    variants.push_back({ mode, alignment });
+            }
+        }
+        return variants;
+    }
+
+    PortfolioAlgorithm::PortfolioAlgorithm(const AlgorithmSettings& settings, PortfolioPolicy policy)
+        : PortfolioAlgorithm(settings, defaultPortfolio(settings), policy) {}
+
+    PortfolioAlgorithm::PortfolioAlgorithm(const AlgorithmSettings& settings, const std::vector<PortfolioVariant>& variants,
+        PortfolioPolicy policy) : variants{ variants }, policy{ policy } {
+        if (variants.empty())
+            throw std::invalid_argument("Portfolio has no variants");
+        for (auto& v : variants) {
+            AlgorithmSettings variant_settings = settings;
+            variant_settings.grid_mode = v.grid_mode;
+            variant_settings.alignment = v.alignment;
+            algorithms.push_back(std::make_unique<GridBasedAlgorithm>(variant_settings));
+        }
+    }
+
+    std::optional<objects::ResultData> PortfolioAlgorithm::calculate(const objects::Scene& scene) {
+        return calculate(objects::SceneView(scene));
+    }
+
+    std::optional<objects::ResultData> PortfolioAlgorithm::calculate(const objects::SceneView& scene) {
+        size_t count = algorithms.size();
+        std::vector<CancellationToken> tokens(count);
+        std::vector<objects::ResultData> results(count);
+        std::vector<std::exception_ptr> errors(count);
+        std::mutex mutex;
+        std::optional<size_t> winner;
+
+        auto cancel = [&](size_t from, size_t except) {
+            for (size_t j = from; j < count; ++j) {
+                if (j != except)
+                    tokens[j].cancel();
+            }
+        };
+        auto run = [&](size_t i) {
+            SolveStatus status = SolveStatus::FAILED;
+            try {
+                status = algorithms[i]->calculate(scene, results[i], tokens[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            if (status != SolveStatus::SOLVED)
+                return;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (policy == PortfolioPolicy::FIRST_FINISHED) {
+                if (winner)
+                    return;
+                winner = i;
+                cancel(0, i);
+            } else {
+                // Earlier variants are still running and may replace this result
+                if (winner && *winner < i)
+                    return;
+                winner = i;
+                cancel(i + 1, i);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(count - 1);
+        try {
+            for (size_t i = 1; i < count; ++i)
+                threads.emplace_back(run, i);
+        } catch (...) {
+            cancel(0, count);
+            for (auto& t : threads)
+                t.join();
+            throw;
+        }
+        run(0);
+        for (auto& t : threads)
+            t.join();
+
+        last_winner = winner;
+        if (winner)
+            return std::move(results[*winner]);
+        for (auto& e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+        return std::nullopt;
+    }
+}
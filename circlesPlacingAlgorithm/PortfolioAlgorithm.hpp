@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "Algorithm.hpp"
+#include "objects.hpp"
+
+namespace algo {
+    struct PortfolioVariant {
+        GridCalculationMode grid_mode;
+        LayoutAlignment alignment;
+    };
+
+    enum class PortfolioPolicy {
+        FIRST_FINISHED, // result of the variant which succeeds first, it may differ between runs
+        VARIANTS_ORDER  // result of the first successful variant in the portfolio order, the same for every run
+    };
+
+    // All the modes and alignments, the variant of the settings goes first
+    std::vector<PortfolioVariant> defaultPortfolio(const AlgorithmSettings& settings = {});
+
+    // Races several grid modes and layout alignments on separate threads. The first variant is solved on
+    // the calling thread, as soon as the winner is known the variants which can't replace it are cancelled.
+    // Every variant keeps its own GridBasedAlgorithm, so an instance can't be used by several threads at once.
+    class PortfolioAlgorithm : public Algorithm {
+    public:
+        explicit PortfolioAlgorithm(const AlgorithmSettings& settings = {}, PortfolioPolicy policy = PortfolioPolicy::FIRST_FINISHED);
+        PortfolioAlgorithm(const AlgorithmSettings& settings, const std::vector<PortfolioVariant>& variants,
+            PortfolioPolicy policy = PortfolioPolicy::FIRST_FINISHED);
+
+        // nullopt if no variant can place the circles. An exception of a variant is rethrown only in this case.
+        std::optional<objects::ResultData> calculate(const objects::Scene& scene) override;
+        std::optional<objects::ResultData> calculate(const objects::SceneView& scene) override;
+
+        // Index of the variant which produced the last result
+        std::optional<size_t> lastWinner() const { return last_winner; }
+        const std::vector<PortfolioVariant>& getVariants() const { return variants; }
+
+    private:
+        std::vector<PortfolioVariant> variants;
+        std::vector<std::unique_ptr<GridBasedAlgorithm>> algorithms;
+        PortfolioPolicy policy;
+        std::optional<size_t> last_winner;
+    };
+}
@@ -0,0 +1,69 @@
+#include "RadixSort.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+namespace algo {
+    namespace {
+        constexpr unsigned digit_bits = 13;
+        constexpr size_t buckets = size_t{ 1 } << digit_bits;
+        // Below it the counting passes cost more than a comparison sort
+        constexpr size_t radix_min_size = 256;
+
+        // Unsigned key growing with the value: the sign bit is flipped for positive values,
+        // all the bits are flipped for negative ones. The key is inverted for the decreasing order.
+        // Single precision values are widened to double exactly, the low digits are then equal and their passes skipped.
+        uint64_t descendingKey(double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            uint64_t ascending = (bits >> 63) ? ~bits : bits | (uint64_t{ 1 } << 63);
+            return ~ascending;
+        }
+    }
+
+    std::pmr::vector<size_t> radixOrderDescending(objects::ArrayView<objects::Scalar> values, std::pmr::memory_resource* resource) {
+        size_t n = values.size();
+        std::pmr::vector<size_t> order(n, resource);
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        if (n < radix_min_size) {
+            // Indices break the ties instead of std::stable_sort, which takes its buffer from the heap
+            std::sort(order.begin(), order.end(), [&values](size_t a, size_t b) {
+                return values[a] > values[b] || (values[a] == values[b] && a < b); });
+            return order;
+        }
+
+        std::pmr::vector<uint64_t> keys(n, resource);
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = descendingKey(values[i]);
+
+        std::pmr::vector<uint64_t> keys_tmp(n, resource);
+        std::pmr::vector<size_t> order_tmp(n, resource);
+        std::pmr::vector<size_t> offsets(buckets, resource);
+        for (unsigned shift = 0; shift < 64; shift += digit_bits) {
+            std::fill(offsets.begin(), offsets.end(), 0);
+            for (auto k : keys)
+                offsets[(k >> shift) & (buckets - 1)]++;
+
+            // All the keys share the digit, the pass wouldn't change anything
+            if (offsets[(keys[0] >> shift) & (buckets - 1)] == n)
+                continue;
+
+            size_t sum = 0;
+            for (auto& o : offsets) {
+                size_t count = o;
+                o = sum;
+                sum += count;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                size_t pos = offsets[(keys[i] >> shift) & (buckets - 1)]++;
+                keys_tmp[pos] = keys[i];
+                order_tmp[pos] = order[i];
+            }
+            keys.swap(keys_tmp);
+            order.swap(order_tmp);
+        }
+        return order;
+    }
+}
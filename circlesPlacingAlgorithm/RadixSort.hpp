@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "objects.hpp"
+
+namespace algo {
+    // Permutation ordering values by decreasing value, equal values keep their order.
+    // LSD radix sort of the IEEE-754 bits, the values themselves are not moved.
+    // The permutation and the sorting buffers are allocated from the resource.
+    std::pmr::vector<size_t> radixOrderDescending(objects::ArrayView<objects::Scalar> values,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+}
@@ -0,0 +1,70 @@
+#include "SolveArena.hpp"
+
+#include <algorithm>
+
+namespace algo {
+    SolveArena::SolveArena(size_t retained_limit) : retained_limit{ retained_limit } {
+        resetBuffer(0);
+    }
+
+    void SolveArena::release() {
+        size_t used = usage.used;
+        usage.used = 0;
+        arena->release();
+
+        size_t size = buffer_size;
+        if (overflow.allocated > 0) {
+            // Chunks taken from the heap hold at least the memory the solve used beyond the buffer
+            size = std::max(std::min(buffer_size + overflow.allocated, retained_limit), buffer_size);
+            small_solves = 0;
+        } else if (used < buffer_size / 4) {
+            // A single big scene doesn't pin its memory once the following ones are much smaller
+            if (++small_solves >= shrink_after_solves) {
+                size = std::min(used * 2, buffer_size);
+                small_solves = 0;
+            }
+        } else {
+            small_solves = 0;
+        }
+        overflow.allocated = 0;
+        if (size != buffer_size)
+            resetBuffer(size);
+    }
+
+    void SolveArena::resetBuffer(size_t size) {
+        arena.reset();
+        buffer.reset(size ? new std::byte[size] : nullptr);
+        buffer_size = size;
+        if (size)
+            arena.emplace(buffer.get(), buffer_size, &overflow);
+        else
+            arena.emplace(&overflow);
+        usage.upstream = &*arena;
+    }
+
+    void* SolveArena::OverflowResource::do_allocate(size_t bytes, size_t alignment) {
+        allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void SolveArena::OverflowResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool SolveArena::OverflowResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+    void* SolveArena::UsageResource::do_allocate(size_t bytes, size_t alignment) {
+        used += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void SolveArena::UsageResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool SolveArena::UsageResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+}
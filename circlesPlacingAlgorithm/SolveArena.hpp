@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace algo {
+    // Monotonic memory of a solve kept between solves. Memory taken from the heap once the buffer is exhausted
+    // is merged into the buffer when the solve is released, so similar scenes are then solved without the heap.
+    // The buffer doesn't grow above the retained limit, and it shrinks once the solves keep using a small part of it.
+    class SolveArena {
+    public:
+        static constexpr size_t default_retained_limit = size_t{ 256 } << 20;
+        // Solves in a row using less than a quarter of the buffer, after which it is shrunk
+        static constexpr size_t shrink_after_solves = 8;
+
+        explicit SolveArena(size_t retained_limit = default_retained_limit);
+        SolveArena(const SolveArena&) = delete;
+        SolveArena& operator=(const SolveArena&) = delete;
+
+        std::pmr::memory_resource* resource() { return &usage; }
+        size_t capacity() const { return buffer_size; }
+        // Everything allocated from the resource has to be deallocated before
+        void release();
+
+    private:
+        // Heap memory counting the bytes it gave to the arena
+        class OverflowResource : public std::pmr::memory_resource {
+        public:
+            size_t allocated{};
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+        };
+
+        // Front of the arena counting the bytes a solve takes from it
+        class UsageResource : public std::pmr::memory_resource {
+        public:
+            std::pmr::memory_resource* upstream{};
+            size_t used{};
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+        };
+
+        OverflowResource overflow;
+        UsageResource usage;
+        size_t retained_limit;
+        size_t small_solves{};
+        std::unique_ptr<std::byte[]> buffer;
+        size_t buffer_size{};
+        std::optional<std::pmr::monotonic_buffer_resource> arena;
+
+        void resetBuffer(size_t size);
+    };
+}
@@ -0,0 +1,80 @@
+#include "ThreadPool.hpp"
+
+namespace algo {
+    ThreadPool::ThreadPool(size_t threads) {
+        try {
+            for (size_t i = 0; i < threads; ++i)
+                workers.emplace_back(&ThreadPool::work, this);
+        } catch (...) {
+            // Joinable threads can't be destroyed, the started workers are stopped first
+            stop();
+            throw;
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        stop();
+    }
+
+    void ThreadPool::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        run_started.notify_all();
+        for (auto& w : workers)
+            w.join();
+    }
+
+    void ThreadPool::run(size_t count, const std::function<void(size_t)>& run_task) {
+        std::lock_guard<std::mutex> run_lock(run_mutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &run_task;
+            tasks_count = count;
+            next_task = 0;
+            error = nullptr;
+            busy_workers = workers.size();
+            generation++;
+        }
+        run_started.notify_all();
+        runTasks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        run_finished.wait(lock, [this] { return busy_workers == 0; });
+        task = nullptr;
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void ThreadPool::runTasks() {
+        for (size_t i = next_task++; i < tasks_count; i = next_task++) {
+            try {
+                (*task)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    }
+
+    void ThreadPool::work() {
+        size_t done_generation = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                run_started.wait(lock, [&] { return stopping || generation != done_generation; });
+                if (stopping)
+                    return;
+                done_generation = generation;
+            }
+
+            runTasks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy_workers == 0)
+                run_finished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace algo {
+    // Runs the tasks of a call on threads kept between the calls, the calling thread takes tasks too.
+    // Calls of several threads at once are run one after another.
+    class ThreadPool {
+    public:
+        // threads - workers besides the calling thread
+        explicit ThreadPool(size_t threads);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        size_t threadsCount() const { return workers.size() + 1; }
+
+        // Runs task(i) for every i < count and returns once all of them are done.
+        // The first exception thrown by a task is rethrown. Passing the task by std::ref doesn't allocate.
+        void run(size_t count, const std::function<void(size_t)>& task);
+
+    private:
+        std::vector<std::thread> workers;
+
+        std::mutex run_mutex;
+        std::mutex mutex;
+        std::condition_variable run_started;
+        std::condition_variable run_finished;
+        // Current call, guarded by mutex except next_task
+        const std::function<void(size_t)>* task{};
+        size_t tasks_count{};
+        std::atomic<size_t> next_task{};
+        size_t generation{};
+        size_t busy_workers{};
+        std::exception_ptr error;
+        bool stopping{};
+
+        void work();
+        void runTasks();
+        void stop();
+    };
+}
@@ -1,7 +1,117 @@
 #include "objects.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <ostream>
 
 namespace objects{
+    namespace {
+        // Invalid elements are marked in blocks of 64 bits by a loop without branches, which compilers vectorize,
+        // then only the marked ones are visited
+        template <typename IsInvalid, typename ErrorOf>
+        ValidationErrors findInvalid(size_t count, IsInvalid isInvalid, ErrorOf errorOf) {
+            ValidationErrors errors;
+            for (size_t block = 0; block < count; block += 64) {
+                size_t block_size = std::min<size_t>(count - block, 64);
+                uint64_t mask = 0;
+                for (size_t j = 0; j < block_size; ++j)
+                    mask |= static_cast<uint64_t>(isInvalid(block + j)) << j;
+                for (size_t j = 0; mask != 0; ++j, mask >>= 1) {
+                    if (mask & 1)
+                        errors.push_back({ block + j, errorOf(block + j) });
+                }
+            }
+            return errors;
+        }
+
+        void checkSizes(size_t a, size_t b, size_t c) {
+            if (a != b || a != c)
+                throw ObjectConstructionException("Arrays sizes differ");
+        }
+    }
+
+    const char* errorMessage(ValidationError error) {
+        switch (error) {
+        case ValidationError::UNNORMALIZED_RECTANGLE:
+            return "Unnormalized rectangle";
+        case ValidationError::AREA_OUTSIDE_ZONE:
+            return "Incorrect exclusion areas positions";
+        case ValidationError::INCORRECT_RADIUSES:
+            return "Incorrect circle radiuses";
+        }
+        return "";
+    }
+
+    ValidationErrors validateExclusionAreas(const Rectangle& zone, ArrayView<Point> min_points, ArrayView<Point> max_points) {
+        if (min_points.size() != max_points.size())
+            throw ObjectConstructionException("Arrays sizes differ");
+
+        Point zone_min = zone.minPoint();
+        Point zone_max = zone.maxPoint();
+        // Same conditions as the Rectangle constructor and Scene::addExclusionArea, combined with & to avoid branches
+        auto unnormalized = [&](size_t i) {
+            return (min_points[i].x >= max_points[i].x) & (min_points[i].y >= max_points[i].y);
+        };
+        auto inside = [&](size_t i) {
+            return (min_points[i].x >= zone_min.x) & (min_points[i].y >= zone_min.y) &
+                (max_points[i].x <= zone_max.x) & (max_points[i].y <= zone_max.y);
+        };
+        return findInvalid(min_points.size(),
+            [&](size_t i) { return unnormalized(i) | !inside(i); },
+            [&](size_t i) { return unnormalized(i) ? ValidationError::UNNORMALIZED_RECTANGLE : ValidationError::AREA_OUTSIDE_ZONE; });
+    }
+
+    ValidationErrors validateCircles(ArrayView<Scalar> in_rads, ArrayView<Scalar> out_rads) {
+        if (in_rads.size() != out_rads.size())
+            throw ObjectConstructionException("Arrays sizes differ");
+
+        return findInvalid(in_rads.size(),
+            [&](size_t i) { return (in_rads[i] > out_rads[i]) | (in_rads[i] <= 0); },
+            [](size_t) { return ValidationError::INCORRECT_RADIUSES; });
+    }
+
+    ValidationErrors Scene::addExclusionAreas(ArrayView<Point> min_points, ArrayView<Point> max_points) {
+        auto errors = validateExclusionAreas(zone, min_points, max_points);
+        exclusion_areas.reserve(exclusion_areas.size() + min_points.size() - errors.size());
+        size_t next_error = 0;
+        for (size_t i = 0; i < min_points.size(); ++i) {
+            if (next_error < errors.size() && errors[next_error].index == i)
+                next_error++;
+            else
+                exclusion_areas.push_back(Rectangle{ min_points[i], max_points[i] });
+        }
+        return errors;
+    }
+
+    ValidationErrors Scene::addCircles(ArrayView<int> ids, ArrayView<Scalar> in_rads, ArrayView<Scalar> out_rads) {
+        checkSizes(ids.size(), in_rads.size(), out_rads.size());
+        auto errors = validateCircles(in_rads, out_rads);
+        circles.reserve(circles.size() + ids.size() - errors.size());
+        size_t next_error = 0;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (next_error < errors.size() && errors[next_error].index == i)
+                next_error++;
+            else
+                circles.push_back(Circle{ ids[i], in_rads[i], out_rads[i] });
+        }
+        return errors;
+    }
+
+    CirclesView::CirclesView(ArrayView<int> ids, ArrayView<Scalar> in_rads, ArrayView<Scalar> out_rads) :
+        ids{ ids }, in_rads{ in_rads }, out_rads{ out_rads } {
+        checkSizes(ids.size(), in_rads.size(), out_rads.size());
+        auto errors = validateCircles(in_rads, out_rads);
+        if (!errors.empty())
+            throw ObjectConstructionException(errorMessage(errors.front().error));
+    }
+
+    SceneView::SceneView(const Rectangle& zone, ArrayView<Rectangle> exclusion_areas, CirclesView circles) :
+        zone{ zone }, exclusion_areas{ exclusion_areas }, circles{ circles } {
+        for (auto& area : exclusion_areas) {
+            if (!(area.minPoint() >= zone.minPoint() && area.maxPoint() <= zone.maxPoint()))
+                throw ObjectConstructionException("Incorrect exclusion areas positions");
+        }
+    }
+
     std::ostream& operator<< (std::ostream& out, const Point& p) {
         out << "{" << p.x << " " << p.y << "}";
         return out;
@@ -26,14 +136,15 @@ namespace objects{
         out << "Z: " << s.getZone() << "\n";
         for (auto& a : s.getExclusionAreas())
             out << "A: " << a << "\n";
-        for (auto& c : s.getCircles())
-            out << "C: " << c << "\n";
+        auto& circles = s.getCircles();
+        for (size_t i = 0; i < circles.size(); ++i)
+            out << "C: " << circles[i] << "\n";
         return out;
     }
 
     std::ostream& operator<< (std::ostream& out, const ResultData& d) {
-        for (auto& c : d.circles)
-            out << "C: " << c << "\n";
+        for (size_t i = 0; i < d.circles.size(); ++i)
+            out << "C: " << d.circles[i] << "\n";
         return out;
     }
 }
@@ -1,11 +1,20 @@
 #pragma once
 
+#include <cstddef>
 #include <iosfwd>
 #include <vector>
 #include <string>
 #include <exception>
 
 namespace objects {
+    // Precision of the geometry and of the algorithm, chosen at compile time.
+    // CIRCLES_SINGLE_PRECISION halves the memory of huge scenes at the cost of rounding errors.
+#ifdef CIRCLES_SINGLE_PRECISION
+    using Scalar = float;
+#else
+    using Scalar = double;
+#endif
+
     class ObjectConstructionException : public std::exception {
     public:
         ObjectConstructionException(const std::string& error = "") { error_str += error; }
@@ -14,9 +23,29 @@ namespace objects {
         std::string error_str{ "Object construction exception: " };
     };
 
+    // Non-owning view of an array, the array has to outlive the view
+    template <typename T>
+    class ArrayView {
+    public:
+        ArrayView() = default;
+        ArrayView(const T* data, size_t size) : ptr{ data }, count{ size } {}
+        ArrayView(const std::vector<T>& values) : ptr{ values.data() }, count{ values.size() } {}
+
+        const T* data() const { return ptr; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& operator[](size_t i) const { return ptr[i]; }
+        const T* begin() const { return ptr; }
+        const T* end() const { return ptr + count; }
+
+    private:
+        const T* ptr{};
+        size_t count{};
+    };
+
     struct Point {
-        double x{};
-        double y{};
+        Scalar x{};
+        Scalar y{};
     };
 
     inline bool operator>(const Point& a, const Point& b) { return a.x > b.x && a.y > b.y; }
@@ -43,32 +72,162 @@ namespace objects {
 
     class Circle {
     public:
-        Circle(int id, double inner, double outter) : id{ id }, inner_rad{ inner }, outter_rad{ outter } {
+        Circle(int id, Scalar inner, Scalar outter) : id{ id }, inner_rad{ inner }, outter_rad{ outter } {
             if (inner > outter || inner <= 0)
                 throw ObjectConstructionException("Incorrect circle radiuses");
         }
-        double inRad() const { return inner_rad; }
-        double outRad() const { return outter_rad; }
+        Scalar inRad() const { return inner_rad; }
+        Scalar outRad() const { return outter_rad; }
         int getId() const { return id; }
 
     private:
-        double inner_rad;
-        double outter_rad;
+        Scalar inner_rad;
+        Scalar outter_rad;
         int id;
     };
 
     class PositionedCircle : public Circle {
     public:
-        PositionedCircle(int id, double inner, double outter) : Circle{id, inner, outter} {}
+        PositionedCircle(int id, Scalar inner, Scalar outter) : Circle{id, inner, outter} {}
         PositionedCircle(const Circle& circle, Point p) : Circle{ circle }, position{p} {}
         PositionedCircle(const Circle& circle) : Circle{circle} {}
         Point position{};
     };
     
+    // Circles stored as separate arrays of their fields, the i-th circle is {ids[i], in_rads[i], out_rads[i]}
+    class Circles {
+    public:
+        void reserve(size_t count) {
+            ids.reserve(count);
+            in_rads.reserve(count);
+            out_rads.reserve(count);
+        }
+        // Keeps the capacity
+        void clear() {
+            ids.clear();
+            in_rads.clear();
+            out_rads.clear();
+        }
+        void push_back(const Circle& circle) {
+            ids.push_back(circle.getId());
+            in_rads.push_back(circle.inRad());
+            out_rads.push_back(circle.outRad());
+        }
+
+        size_t size() const { return ids.size(); }
+        bool empty() const { return ids.empty(); }
+        Circle operator[](size_t i) const { return Circle{ ids[i], in_rads[i], out_rads[i] }; }
+
+        int getId(size_t i) const { return ids[i]; }
+        Scalar inRad(size_t i) const { return in_rads[i]; }
+        Scalar outRad(size_t i) const { return out_rads[i]; }
+        const std::vector<int>& getIds() const { return ids; }
+        const std::vector<Scalar>& getInRads() const { return in_rads; }
+        const std::vector<Scalar>& getOutRads() const { return out_rads; }
+
+    private:
+        std::vector<int> ids;
+        std::vector<Scalar> in_rads;
+        std::vector<Scalar> out_rads;
+    };
+
+    // Positioned circles stored as separate arrays of their fields. The circles are kept in a Circles member,
+    // so they can't be changed without their positions.
+    class PositionedCircles {
+    public:
+        void reserve(size_t count) {
+            circles.reserve(count);
+            xs.reserve(count);
+            ys.reserve(count);
+        }
+        // Keeps the capacity
+        void clear() {
+            circles.clear();
+            xs.clear();
+            ys.clear();
+        }
+        void push_back(const PositionedCircle& circle) {
+            circles.push_back(circle);
+            xs.push_back(circle.position.x);
+            ys.push_back(circle.position.y);
+        }
+
+        size_t size() const { return circles.size(); }
+        bool empty() const { return circles.empty(); }
+        PositionedCircle operator[](size_t i) const { return PositionedCircle{ circles[i], position(i) }; }
+
+        int getId(size_t i) const { return circles.getId(i); }
+        Scalar inRad(size_t i) const { return circles.inRad(i); }
+        Scalar outRad(size_t i) const { return circles.outRad(i); }
+        Point position(size_t i) const { return { xs[i], ys[i] }; }
+        const std::vector<int>& getIds() const { return circles.getIds(); }
+        const std::vector<Scalar>& getInRads() const { return circles.getInRads(); }
+        const std::vector<Scalar>& getOutRads() const { return circles.getOutRads(); }
+        const std::vector<Scalar>& getXs() const { return xs; }
+        const std::vector<Scalar>& getYs() const { return ys; }
+        // The circles without their positions
+        const Circles& getCircles() const { return circles; }
+
+    private:
+        Circles circles;
+        std::vector<Scalar> xs;
+        std::vector<Scalar> ys;
+    };
+
+    // Non-owning view of circles kept in separate arrays of their fields
+    class CirclesView {
+    public:
+        CirclesView() = default;
+        // The arrays sizes and the radiuses are checked as the Circle constructor does
+        CirclesView(ArrayView<int> ids, ArrayView<Scalar> in_rads, ArrayView<Scalar> out_rads);
+        CirclesView(const Circles& circles) :
+            ids{ circles.getIds() }, in_rads{ circles.getInRads() }, out_rads{ circles.getOutRads() } {}
+
+        size_t size() const { return ids.size(); }
+        bool empty() const { return ids.empty(); }
+        Circle operator[](size_t i) const { return Circle{ ids[i], in_rads[i], out_rads[i] }; }
+
+        int getId(size_t i) const { return ids[i]; }
+        Scalar inRad(size_t i) const { return in_rads[i]; }
+        Scalar outRad(size_t i) const { return out_rads[i]; }
+        ArrayView<int> getIds() const { return ids; }
+        ArrayView<Scalar> getInRads() const { return in_rads; }
+        ArrayView<Scalar> getOutRads() const { return out_rads; }
+
+    private:
+        ArrayView<int> ids;
+        ArrayView<Scalar> in_rads;
+        ArrayView<Scalar> out_rads;
+    };
+
+    enum class ValidationError {
+        UNNORMALIZED_RECTANGLE, AREA_OUTSIDE_ZONE, INCORRECT_RADIUSES
+    };
+
+    // Element rejected by a bulk validation, index is its position in the validated arrays
+    struct InvalidElement {
+        size_t index;
+        ValidationError error;
+    };
+
+    using ValidationErrors = std::vector<InvalidElement>;
+
+    const char* errorMessage(ValidationError error);
+
+    // Bulk checks done by the Rectangle and Circle constructors and by Scene::addExclusionArea. The arrays are
+    // checked in one pass without branches on the data, the invalid elements are listed by increasing index.
+    ValidationErrors validateExclusionAreas(const Rectangle& zone, ArrayView<Point> min_points, ArrayView<Point> max_points);
+    ValidationErrors validateCircles(ArrayView<Scalar> in_rads, ArrayView<Scalar> out_rads);
+
     class Scene {
     public:
         Scene(const Rectangle& zone) : zone{zone} {}
 
+        // Bulk additions: the valid elements are added, the invalid ones are returned instead of throwing.
+        // Only different arrays sizes throw.
+        ValidationErrors addExclusionAreas(ArrayView<Point> min_points, ArrayView<Point> max_points);
+        ValidationErrors addCircles(ArrayView<int> ids, ArrayView<Scalar> in_rads, ArrayView<Scalar> out_rads);
+
         void addExclusionArea(const Rectangle& area) {
             if (area.minPoint() >= zone.minPoint() && area.maxPoint() <= zone.maxPoint())
                 exclusion_areas.push_back(area); 
@@ -78,19 +237,40 @@ namespace objects {
         void addCircle(const Circle& circle) {
             circles.push_back(circle);
         }
+        void reserveCircles(size_t count) {
+            circles.reserve(count);
+        }
 
         const std::vector<Rectangle>& getExclusionAreas() const { return exclusion_areas; }
-        const std::vector<Circle>& getCircles() const { return circles; }
+        const Circles& getCircles() const { return circles; }
         const Rectangle& getZone() const { return zone; }
 
     private:
         Rectangle zone;
         std::vector<Rectangle> exclusion_areas;
-        std::vector<Circle> circles;
+        Circles circles;
+    };
+
+    // Non-owning view of a scene, lets scenes kept in caller's arrays be solved without copying them into a Scene
+    class SceneView {
+    public:
+        // Exclusion areas are checked to be inside the zone as Scene::addExclusionArea does
+        SceneView(const Rectangle& zone, ArrayView<Rectangle> exclusion_areas, CirclesView circles);
+        SceneView(const Scene& scene) :
+            zone{ scene.getZone() }, exclusion_areas{ scene.getExclusionAreas() }, circles{ scene.getCircles() } {}
+
+        ArrayView<Rectangle> getExclusionAreas() const { return exclusion_areas; }
+        const CirclesView& getCircles() const { return circles; }
+        const Rectangle& getZone() const { return zone; }
+
+    private:
+        Rectangle zone;
+        ArrayView<Rectangle> exclusion_areas;
+        CirclesView circles;
     };
 
     struct ResultData {
-        std::vector<PositionedCircle> circles;
+        PositionedCircles circles;
     };
 
     std::ostream& operator<< (std::ostream& out, const Point& p);
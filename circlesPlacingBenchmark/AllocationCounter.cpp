@@ -0,0 +1,69 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<size_t> allocations{};
+    std::atomic<size_t> current_bytes{};
+    std::atomic<size_t> peak_bytes{};
+
+    // Block size is stored in front of every allocation so that unsized delete can account it
+    constexpr size_t header_size = alignof(std::max_align_t);
+
+    void* countedAlloc(size_t size) {
+        void* block = std::malloc(size + header_size);
+        if (!block)
+            return nullptr;
+        *static_cast<size_t*>(block) = size;
+
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        size_t now = current_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = peak_bytes.load(std::memory_order_relaxed);
+        while (now > peak && !peak_bytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+
+        return static_cast<char*>(block) + header_size;
+    }
+
+    void countedFree(void* ptr) noexcept {
+        if (!ptr)
+            return;
+        void* block = static_cast<char*>(ptr) - header_size;
+        current_bytes.fetch_sub(*static_cast<size_t*>(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+namespace benchmark {
+    AllocationStats allocationStats() {
+        return { allocations.load(), current_bytes.load(), peak_bytes.load() };
+    }
+
+    void resetAllocationStats() {
+        allocations = 0;
+        peak_bytes = current_bytes.load();
+    }
+}
+
+void* operator new(size_t size) {
+    if (void* ptr = countedAlloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* ptr = countedAlloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr); }
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+namespace benchmark {
+    // Heap usage statistics collected by the replaced global operator new / delete
+    struct AllocationStats {
+        size_t allocations{};
+        size_t current_bytes{};
+        size_t peak_bytes{};
+    };
+
+    AllocationStats allocationStats();
+
+    // Drops allocations counter and sets peak to the currently allocated bytes
+    void resetAllocationStats();
+}
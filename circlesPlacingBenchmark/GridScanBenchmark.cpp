@@ -0,0 +1,98 @@
+#include "GridScanBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <stdexcept>
+
+#include "../circlesPlacingAlgorithm/BitGrid.hpp"
+
+namespace benchmark {
+    namespace {
+        struct Block {
+            size_t x0, x1, y0, y1;
+        };
+
+        std::vector<Block> generateBlocks(size_t side, std::mt19937_64& rng) {
+            std::uniform_int_distribution<size_t> pos_dist(0, side - 1);
+            std::uniform_int_distribution<size_t> size_dist(1, std::max<size_t>(side / 8, 1));
+
+            std::vector<Block> blocks(std::max<size_t>(side / 4, 1));
+            for (auto& b : blocks) {
+                b.x0 = pos_dist(rng);
+                b.y0 = pos_dist(rng);
+                b.x1 = std::min(side, b.x0 + size_dist(rng));
+                b.y1 = std::min(side, b.y0 + size_dist(rng));
+            }
+            return blocks;
+        }
+
+        size_t scanVectorBool(const std::vector<bool>& grid, size_t side) {
+            size_t runs = 0;
+            for (size_t i = 0; i < side; ++i) {
+                for (size_t j = 0; j < side; ++j) {
+                    auto beginInd = i * side + j;
+                    if (grid[beginInd]) {
+                        auto rowBeginInd = i * side;
+                        auto rowEndInd = (i + 1) * side;
+                        auto endInd = std::adjacent_find(grid.begin() + beginInd, grid.begin() + rowEndInd, std::not_equal_to<bool>());
+                        if (endInd == grid.begin() + rowEndInd)
+                            endInd--;
+                        j = std::distance(grid.begin() + rowBeginInd, endInd);
+                        runs++;
+                    }
+                }
+            }
+            return runs;
+        }
+
+        size_t scanBitGrid(const algo::BitGrid& grid) {
+            size_t runs = 0;
+            for (size_t i = 0; i < grid.height(); ++i) {
+                for (size_t j = grid.findSet(i, 0); j < grid.width(); j = grid.findSet(i, grid.findClear(i, j)))
+                    runs++;
+            }
+            return runs;
+        }
+
+        template <typename F>
+        double measureMs(size_t repeats, F&& f) {
+            double best = 0.0;
+            for (size_t r = 0; r < repeats; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                f();
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                best = (r == 0) ? ms : std::min(best, ms);
+            }
+            return best;
+        }
+    }
+
+    std::vector<GridScanMeasurement> runGridScan(size_t min_side, size_t max_side, size_t repeats, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::vector<GridScanMeasurement> measurements;
+        for (size_t side = min_side; side <= max_side; side *= 2) {
+            auto blocks = generateBlocks(side, rng);
+
+            std::vector<bool> vector_grid(side * side, true);
+            algo::BitGrid bit_grid(side, side, true);
+            for (auto& b : blocks) {
+                for (size_t i = b.y0; i < b.y1; ++i) {
+                    std::fill(vector_grid.begin() + side * i + b.x0, vector_grid.begin() + side * i + b.x1, false);
+                    bit_grid.setRange(i, b.x0, b.x1, false);
+                }
+            }
+
+            GridScanMeasurement m;
+            m.side = side;
+            size_t vector_runs = 0;
+            m.vector_bool_ms = measureMs(repeats, [&]() { vector_runs = scanVectorBool(vector_grid, side); });
+            m.bit_grid_ms = measureMs(repeats, [&]() { m.runs = scanBitGrid(bit_grid); });
+            if (vector_runs != m.runs)
+                throw std::logic_error("Grid scan implementations found different runs");
+            measurements.push_back(m);
+        }
+        return measurements;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace benchmark {
+    struct GridScanMeasurement {
+        size_t side{};
+        size_t runs{};
+        double vector_bool_ms{};
+        double bit_grid_ms{};
+    };
+
+    // Compares free runs extraction from std::vector<bool> with std::adjacent_find (the former AreasGrid
+    // implementation) against the word-packed BitGrid on square grids with side growing by 2x.
+    // Every grid has side / 4 random rectangles cleared, which roughly matches grids built from exclusion areas.
+    std::vector<GridScanMeasurement> runGridScan(size_t min_side, size_t max_side, size_t repeats, uint64_t seed);
+}
@@ -0,0 +1,98 @@
+#include "SceneGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace benchmark {
+    namespace {
+        // Scenes are generated in double precision whatever precision the algorithm is built with
+        objects::Point makePoint(double x, double y) {
+            return { static_cast<objects::Scalar>(x), static_cast<objects::Scalar>(y) };
+        }
+
+        objects::Circle makeCircle(size_t id, double in_rad, double out_rad) {
+            return { static_cast<int>(id), static_cast<objects::Scalar>(in_rad), static_cast<objects::Scalar>(out_rad) };
+        }
+
+        objects::Rectangle generateArea(const SceneParameters& params, std::mt19937_64& rng, objects::Point center) {
+            std::uniform_real_distribution<double> size_dist(params.area_min_size, params.area_max_size);
+            double w = std::min(size_dist(rng), params.zone_width / 2);
+            double h = std::min(size_dist(rng), params.zone_height / 2);
+
+            double x0 = std::clamp(center.x - w / 2, 0.0, params.zone_width - w);
+            double y0 = std::clamp(center.y - h / 2, 0.0, params.zone_height - h);
+            double x1 = std::min(x0 + w, params.zone_width);
+            double y1 = std::min(y0 + h, params.zone_height);
+            return objects::Rectangle{ makePoint(x0, y0), makePoint(x1, y1) };
+        }
+
+        void addAreas(objects::Scene& scene, const SceneParameters& params, std::mt19937_64& rng) {
+            std::uniform_real_distribution<double> x_dist(0.0, params.zone_width);
+            std::uniform_real_distribution<double> y_dist(0.0, params.zone_height);
+
+            if (params.areas_distribution == AreasDistribution::UNIFORM) {
+                for (size_t i = 0; i < params.areas_count; ++i) {
+                    double x = x_dist(rng);
+                    double y = y_dist(rng);
+                    scene.addExclusionArea(generateArea(params, rng, makePoint(x, y)));
+                }
+                return;
+            }
+
+            std::vector<objects::Point> centers(std::max<size_t>(params.areas_clusters, 1));
+            for (auto& c : centers) {
+                double x = x_dist(rng);
+                double y = y_dist(rng);
+                c = makePoint(x, y);
+            }
+
+            std::normal_distribution<double> x_spread(0.0, params.zone_width / (4.0 * centers.size()));
+            std::normal_distribution<double> y_spread(0.0, params.zone_height / (4.0 * centers.size()));
+            for (size_t i = 0; i < params.areas_count; ++i) {
+                auto& c = centers[i % centers.size()];
+                double x = c.x + x_spread(rng);
+                double y = c.y + y_spread(rng);
+                scene.addExclusionArea(generateArea(params, rng, makePoint(x, y)));
+            }
+        }
+
+        void addCircles(objects::Scene& scene, const SceneParameters& params, std::mt19937_64& rng) {
+            std::uniform_real_distribution<double> rad_dist(params.min_out_rad, params.max_out_rad);
+            std::uniform_real_distribution<double> ratio_dist(params.min_in_ratio, 1.0);
+
+            std::vector<std::pair<double, double>> classes(std::max<size_t>(params.radius_classes, 1));
+            for (auto& c : classes) {
+                c.second = rad_dist(rng);
+                c.first = c.second * ratio_dist(rng);
+            }
+
+            std::uniform_int_distribution<size_t> class_dist(0, classes.size() - 1);
+            for (size_t i = 0; i < params.circles_count; ++i) {
+                if (params.radius_distribution == RadiusDistribution::CLASSES) {
+                    auto& c = classes[class_dist(rng)];
+                    scene.addCircle(makeCircle(i, c.first, c.second));
+                } else {
+                    double out_rad = rad_dist(rng);
+                    double in_rad = out_rad * ratio_dist(rng);
+                    scene.addCircle(makeCircle(i, in_rad, out_rad));
+                }
+            }
+        }
+    }
+
+    objects::Scene generateScene(const SceneParameters& params) {
+        std::mt19937_64 rng(params.seed);
+
+        objects::Scene scene(objects::Rectangle{ makePoint(0.0, 0.0), makePoint(params.zone_width, params.zone_height) });
+        addAreas(scene, params, rng);
+        addCircles(scene, params, rng);
+        return scene;
+    }
+
+    double zoneSideForDensity(const SceneParameters& params, double density) {
+        double mean_diameter = params.min_out_rad + params.max_out_rad;
+        return std::sqrt(params.circles_count * mean_diameter * mean_diameter / density);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../circlesPlacingAlgorithm/objects.hpp"
+
+namespace benchmark {
+    enum class AreasDistribution {
+        UNIFORM, CLUSTERED
+    };
+
+    enum class RadiusDistribution {
+        UNIFORM, CLASSES
+    };
+
+    struct SceneParameters {
+        double zone_width{ 100.0 };
+        double zone_height{ 100.0 };
+
+        size_t areas_count{};
+        AreasDistribution areas_distribution{ AreasDistribution::UNIFORM };
+        size_t areas_clusters{ 4 };
+        double area_min_size{ 2.0 };
+        double area_max_size{ 10.0 };
+
+        size_t circles_count{};
+        RadiusDistribution radius_distribution{ RadiusDistribution::UNIFORM };
+        size_t radius_classes{ 3 };
+        double min_out_rad{ 0.5 };
+        double max_out_rad{ 1.0 };
+        // Inner radius is taken as out_rad * ratio, ratio in [min_in_ratio, 1]
+        double min_in_ratio{ 0.5 };
+
+        uint64_t seed{ 1 };
+    };
+
+    objects::Scene generateScene(const SceneParameters& params);
+
+    // Zone side of a square zone which area is (1 / density) times larger than the summary area of circles squares
+    double zoneSideForDensity(const SceneParameters& params, double density);
+}
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../circlesPlacingAlgorithm/Algorithm.hpp"
+#include "../circlesPlacingAlgorithm/BatchSolver.hpp"
+#include "../circlesPlacingAlgorithm/PlacementCheck.hpp"
+#include "AllocationCounter.hpp"
+#include "GridScanBenchmark.hpp"
+#include "SceneGenerator.hpp"
+
+namespace {
+    enum class OutputFormat {
+        CSV, JSON
+    };
+
+    enum class BenchmarkMode {
+        SCALING, GRID_SCAN, BATCH, CHECKS
+    };
+
+    struct BenchmarkOptions {
+        BenchmarkMode mode{ BenchmarkMode::SCALING };
+        size_t min_circles{ 10 };
+        size_t max_circles{ 1000000 };
+        size_t repeats{ 3 };
+        size_t min_side{ 256 };
+        size_t max_side{ 4096 };
+        double density{ 0.3 };
+        size_t areas{ 10 };
+        size_t batch_scenes{ 64 };
+        size_t batch_threads{ 0 };
+        OutputFormat format{ OutputFormat::CSV };
+        algo::AlgorithmSettings settings;
+        benchmark::SceneParameters scene;
+    };
+
+    struct Measurement {
+        size_t circles{};
+        size_t areas{};
+        double zone_side{};
+        size_t repeat{};
+        double time_ms{};
+        size_t peak_heap_bytes{};
+        size_t allocations{};
+        bool success{};
+        // Layouts the grid builds for the scene in the rows and in the merged mode
+        size_t row_layouts{};
+        size_t merged_layouts{};
+        algo::AlgorithmStats stats;
+    };
+
+    struct BatchMeasurement {
+        size_t circles{};
+        size_t scenes{};
+        size_t threads{};
+        double time_ms{};
+        double serial_ms{};
+        size_t solved{};
+    };
+
+    void printUsage() {
+        std::cout << "Usage: circlesPlacingBenchmark [scaling|gridscan|batch|checks] [options]\n"
+            "scaling: times GridBasedAlgorithm::calculate on generated scenes, counts the layouts of both grid modes\n"
+            "  --min-circles N            smallest scene size (default 10)\n"
+            "  --max-circles N            largest scene size, sizes grow by 10x (default 1000000)\n"
+            "  --repeats N                runs per size (default 3)\n"
+            "  --density D                summary circles squares area / zone area (default 0.3)\n"
+            "  --areas N                  exclusion areas count (default 10)\n"
+            "  --areas-distribution uniform|clustered\n"
+            "  --radius-distribution uniform|classes\n"
+            "  --radius-classes N         radius classes count for 'classes' distribution (default 3)\n"
+            "  --seed N\n"
+            "  --selection first|best     layout selection strategy (default first)\n"
+            "  --grid-threads N           threads used to build big grids (default 1)\n"
+            "  --placement-threads N      threads placing circles of big scenes into separate regions (default 1)\n"
+            "  --positions-threads N      threads computing final circles positions of big scenes (default 1)\n"
+            "  --grid-mode rows|merged    free runs per row or merged vertically (default rows)\n"
+            "  --snap-epsilon E           merge exclusion areas coordinates closer than E (default 0)\n"
+            "  --grid-memory-mb N         dense grid size from which sparse rows are used (default 256)\n"
+            "  --verify on|off            check results for overlaps (default on in single precision builds)\n"
+            "  --verify-tolerance T       overlap allowed by the check, in roundings of the biggest coordinate (default 8)\n"
+            "  --format csv|json          output format (default csv)\n"
+            "gridscan: compares free runs extraction from std::vector<bool> and BitGrid\n"
+            "  --min-side N               smallest grid side (default 256)\n"
+            "  --max-side N               largest grid side, sides grow by 2x (default 4096)\n"
+            "  --repeats N, --seed N, --format csv|json\n"
+            "batch: times BatchSolver against a serial loop on lists of generated scenes of every size\n"
+            "  --batch-scenes N           scenes per batch (default 64)\n"
+            "  --batch-threads N          pool size (default hardware threads)\n"
+            "  the scaling scene and algorithm options apply\n"
+            "checks: solves small scenes with known placements, fails on a wrong one\n";
+    }
+
+    bool parseOptions(int argc, char** argv, BenchmarkOptions& options) {
+        int first = 1;
+        if (argc > 1 && argv[1][0] != '-') {
+            std::string mode = argv[1];
+            if (mode == "gridscan")
+                options.mode = BenchmarkMode::GRID_SCAN;
+            else if (mode == "batch")
+                options.mode = BenchmarkMode::BATCH;
+            else if (mode == "checks")
+                options.mode = BenchmarkMode::CHECKS;
+            else if (mode != "scaling")
+                return false;
+            first = 2;
+        }
+
+        for (int i = first; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || i + 1 >= argc)
+                return false;
+
+            std::string value = argv[++i];
+            if (arg == "--min-circles")
+                options.min_circles = std::stoull(value);
+            else if (arg == "--max-circles")
+                options.max_circles = std::stoull(value);
+            else if (arg == "--min-side")
+                options.min_side = std::stoull(value);
+            else if (arg == "--max-side")
+                options.max_side = std::stoull(value);
+            else if (arg == "--repeats")
+                options.repeats = std::stoull(value);
+            else if (arg == "--density")
+                options.density = std::stod(value);
+            else if (arg == "--areas")
+                options.areas = std::stoull(value);
+            else if (arg == "--areas-distribution")
+                options.scene.areas_distribution = (value == "clustered") ?
+                    benchmark::AreasDistribution::CLUSTERED : benchmark::AreasDistribution::UNIFORM;
+            else if (arg == "--radius-distribution")
+                options.scene.radius_distribution = (value == "classes") ?
+                    benchmark::RadiusDistribution::CLASSES : benchmark::RadiusDistribution::UNIFORM;
+            else if (arg == "--radius-classes")
+                options.scene.radius_classes = std::stoull(value);
+            else if (arg == "--seed")
+                options.scene.seed = std::stoull(value);
+            else if (arg == "--selection")
+                options.settings.selection = (value == "best") ?
+                    algo::LayoutSelection::BEST_FIT : algo::LayoutSelection::FIRST_FIT;
+            else if (arg == "--grid-threads")
+                options.settings.grid_threads = std::stoull(value);
+            else if (arg == "--placement-threads")
+                options.settings.placement_threads = std::stoull(value);
+            else if (arg == "--positions-threads")
+                options.settings.positions_threads = std::stoull(value);
+            else if (arg == "--grid-mode")
+                options.settings.grid_mode = (value == "merged") ?
+                    algo::GridCalculationMode::HORIZONTAL_MERGED : algo::GridCalculationMode::HORIZONTAL;
+            else if (arg == "--snap-epsilon")
+                options.settings.snap_epsilon = std::stod(value);
+            else if (arg == "--grid-memory-mb")
+                options.settings.grid_memory_budget = std::stoull(value) << 20;
+            else if (arg == "--verify")
+                options.settings.verify_results = (value == "on");
+            else if (arg == "--verify-tolerance")
+                options.settings.verify_tolerance = std::stod(value);
+            else if (arg == "--batch-scenes")
+                options.batch_scenes = std::stoull(value);
+            else if (arg == "--batch-threads")
+                options.batch_threads = std::stoull(value);
+            else if (arg == "--format")
+                options.format = (value == "json") ? OutputFormat::JSON : OutputFormat::CSV;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    // Counted from the grid, so the layouts reduction of the merged mode is shown without the statistics
+    std::pair<size_t, size_t> countLayouts(const objects::Scene& scene, const algo::AlgorithmSettings& settings) {
+        auto& in_rads = scene.getCircles().getInRads();
+        objects::Scalar min_side = 2 * *std::min_element(in_rads.begin(), in_rads.end());
+        algo::AreasGrid grid(scene.getZone(), scene.getExclusionAreas(), settings.grid_threads, settings.grid_memory_budget,
+            settings.snap_epsilon);
+        size_t rows = grid.calculateAllowedAreas(algo::GridCalculationMode::HORIZONTAL, settings.alignment, min_side, min_side).size();
+        size_t merged = grid.calculateAllowedAreas(algo::GridCalculationMode::HORIZONTAL_MERGED, settings.alignment, min_side, min_side).size();
+        return { rows, merged };
+    }
+
+    std::vector<Measurement> runScaling(const BenchmarkOptions& options) {
+        std::vector<Measurement> measurements;
+        for (size_t n = options.min_circles; n <= options.max_circles; n *= 10) {
+            auto params = options.scene;
+            params.circles_count = n;
+            params.areas_count = options.areas;
+            params.zone_width = params.zone_height = benchmark::zoneSideForDensity(params, options.density);
+
+            auto scene = benchmark::generateScene(params);
+            auto [row_layouts, merged_layouts] = countLayouts(scene, options.settings);
+            // The algorithm and the result are reused, so the repeats after the first one show the steady state
+            algo::GridBasedAlgorithm algorithm(options.settings);
+            objects::ResultData result;
+            for (size_t r = 0; r < options.repeats; ++r) {
+                Measurement m;
+
+                benchmark::resetAllocationStats();
+                auto base_bytes = benchmark::allocationStats().current_bytes;
+                auto start = std::chrono::steady_clock::now();
+                bool success = algorithm.calculate(scene, result, m.stats);
+                auto finish = std::chrono::steady_clock::now();
+                auto heap = benchmark::allocationStats();
+
+                m.circles = n;
+                m.areas = params.areas_count;
+                m.zone_side = params.zone_width;
+                m.repeat = r;
+                m.row_layouts = row_layouts;
+                m.merged_layouts = merged_layouts;
+                m.time_ms = std::chrono::duration<double, std::milli>(finish - start).count();
+                m.peak_heap_bytes = heap.peak_bytes - base_bytes;
+                m.allocations = heap.allocations;
+                m.success = success;
+                // Threads of big grids and of parallel placement are started by every solve, the rest reuses its memory
+                bool reuses_memory = options.settings.grid_threads <= 1 && options.settings.placement_threads <= 1;
+                if (r > 0 && reuses_memory && m.allocations > 0)
+                    throw std::logic_error("Repeated solve allocated from the heap");
+                measurements.push_back(m);
+            }
+            std::cerr << "n = " << n << " done\n";
+        }
+        return measurements;
+    }
+
+    void printCsv(const std::vector<Measurement>& measurements) {
+        std::cout << "circles,areas,zone_side,repeat,time_ms,peak_heap_bytes,allocations,success,"
+            "init_grid_ms,allowed_areas_ms,fill_layouts_ms,relax_distribution_ms,recalculate_positions_ms,verify_results_ms,"
+            "allowed_layouts,row_layouts,merged_layouts,layouts_scanned_per_placement,run_placements,split_layouts,width_rejections,height_rejections,"
+            "placement_violations\n";
+        for (auto& m : measurements) {
+            std::cout << m.circles << "," << m.areas << "," << m.zone_side << "," << m.repeat << "," <<
+                m.time_ms << "," << m.peak_heap_bytes << "," << m.allocations << "," << m.success << "," <<
+                m.stats.init_grid_ms << "," << m.stats.allowed_areas_ms << "," << m.stats.fill_layouts_ms << "," <<
+                m.stats.relax_distribution_ms << "," << m.stats.recalculate_positions_ms << "," <<
+                m.stats.verify_results_ms << "," << m.stats.allowed_layouts << "," <<
+                m.row_layouts << "," << m.merged_layouts << "," << m.stats.layoutsScannedPerPlacement() << "," << m.stats.run_placements << "," <<
+                m.stats.split_layouts << "," <<
+                m.stats.width_rejections << "," << m.stats.height_rejections << "," << m.stats.placement_violations << "\n";
+        }
+    }
+
+    std::vector<BatchMeasurement> runBatch(const BenchmarkOptions& options) {
+        std::vector<BatchMeasurement> measurements;
+        algo::BatchSolver solver(options.settings, options.batch_threads);
+        for (size_t n = options.min_circles; n <= options.max_circles; n *= 10) {
+            std::vector<objects::Scene> scenes;
+            for (size_t s = 0; s < options.batch_scenes; ++s) {
+                auto params = options.scene;
+                params.seed = options.scene.seed + s;
+                params.circles_count = n;
+                params.areas_count = options.areas;
+                params.zone_width = params.zone_height = benchmark::zoneSideForDensity(params, options.density);
+                scenes.push_back(benchmark::generateScene(params));
+            }
+
+            BatchMeasurement m;
+            m.circles = n;
+            m.scenes = scenes.size();
+            m.threads = solver.threadsCount();
+
+            auto start = std::chrono::steady_clock::now();
+            auto results = solver.solve(scenes);
+            m.time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            for (auto& r : results)
+                m.solved += r.has_value();
+
+            algo::GridBasedAlgorithm algorithm(options.settings);
+            start = std::chrono::steady_clock::now();
+            for (auto& scene : scenes)
+                algorithm.calculate(scene);
+            m.serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            measurements.push_back(m);
+            std::cerr << "n = " << n << " done\n";
+        }
+        return measurements;
+    }
+
+    void printCsv(const std::vector<BatchMeasurement>& measurements) {
+        std::cout << "circles,scenes,threads,time_ms,serial_ms,speedup,solved\n";
+        for (auto& m : measurements) {
+            std::cout << m.circles << "," << m.scenes << "," << m.threads << "," << m.time_ms << "," <<
+                m.serial_ms << "," << m.serial_ms / m.time_ms << "," << m.solved << "\n";
+        }
+    }
+
+    void printJson(const std::vector<BatchMeasurement>& measurements) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < measurements.size(); ++i) {
+            auto& m = measurements[i];
+            std::cout << "  {\"circles\": " << m.circles << ", \"scenes\": " << m.scenes << ", \"threads\": " << m.threads <<
+                ", \"time_ms\": " << m.time_ms << ", \"serial_ms\": " << m.serial_ms <<
+                ", \"speedup\": " << m.serial_ms / m.time_ms << ", \"solved\": " << m.solved << "}";
+            std::cout << (i + 1 < measurements.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+    }
+
+    void printCsv(const std::vector<benchmark::GridScanMeasurement>& measurements) {
+        std::cout << "side,cells,runs,vector_bool_ms,bit_grid_ms\n";
+        for (auto& m : measurements) {
+            std::cout << m.side << "," << m.side * m.side << "," << m.runs << "," <<
+                m.vector_bool_ms << "," << m.bit_grid_ms << "\n";
+        }
+    }
+
+    void printJson(const std::vector<benchmark::GridScanMeasurement>& measurements) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < measurements.size(); ++i) {
+            auto& m = measurements[i];
+            std::cout << "  {\"side\": " << m.side << ", \"cells\": " << m.side * m.side << ", \"runs\": " << m.runs <<
+                ", \"vector_bool_ms\": " << m.vector_bool_ms << ", \"bit_grid_ms\": " << m.bit_grid_ms << "}";
+            std::cout << (i + 1 < measurements.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+    }
+
+    template <typename T>
+    void printMeasurements(const std::vector<T>& measurements, OutputFormat format) {
+        if (format == OutputFormat::JSON)
+            printJson(measurements);
+        else
+            printCsv(measurements);
+    }
+
+    void printJson(const std::vector<Measurement>& measurements) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < measurements.size(); ++i) {
+            auto& m = measurements[i];
+            std::cout << "  {\"circles\": " << m.circles << ", \"areas\": " << m.areas <<
+                ", \"zone_side\": " << m.zone_side << ", \"repeat\": " << m.repeat <<
+                ", \"time_ms\": " << m.time_ms << ", \"peak_heap_bytes\": " << m.peak_heap_bytes <<
+                ", \"allocations\": " << m.allocations << ", \"success\": " << (m.success ? "true" : "false") <<
+                ", \"init_grid_ms\": " << m.stats.init_grid_ms << ", \"allowed_areas_ms\": " << m.stats.allowed_areas_ms <<
+                ", \"fill_layouts_ms\": " << m.stats.fill_layouts_ms <<
+                ", \"relax_distribution_ms\": " << m.stats.relax_distribution_ms <<
+                ", \"recalculate_positions_ms\": " << m.stats.recalculate_positions_ms <<
+                ", \"verify_results_ms\": " << m.stats.verify_results_ms <<
+                ", \"allowed_layouts\": " << m.stats.allowed_layouts <<
+                ", \"row_layouts\": " << m.row_layouts << ", \"merged_layouts\": " << m.merged_layouts <<
+                ", \"layouts_scanned_per_placement\": " << m.stats.layoutsScannedPerPlacement() <<
+                ", \"run_placements\": " << m.stats.run_placements << ", \"split_layouts\": " << m.stats.split_layouts << ", \"width_rejections\": " << m.stats.width_rejections <<
+                ", \"height_rejections\": " << m.stats.height_rejections <<
+                ", \"placement_violations\": " << m.stats.placement_violations << "}";
+            std::cout << (i + 1 < measurements.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+    }
+
+    // An area narrower than the snap epsilon is snapped into a single grid line, the free runs still end at it
+    void checkSnappedArea() {
+        objects::Rectangle area({ 50, 0 }, { 50.0001, 100 });
+        objects::Scene scene(objects::Rectangle({ 0, 0 }, { 100, 100 }));
+        scene.addExclusionArea(area);
+        scene.addCircle(objects::Circle(1, 5, 5));
+
+        algo::AlgorithmSettings settings;
+        settings.snap_epsilon = 1e-3;
+        for (auto mode : { algo::GridCalculationMode::HORIZONTAL, algo::GridCalculationMode::HORIZONTAL_MERGED }) {
+            settings.grid_mode = mode;
+            auto result = algo::GridBasedAlgorithm(settings).calculate(scene);
+            if (!result)
+                throw std::logic_error("Scene with a snapped area is not solved");
+            auto x = result->circles.position(0).x;
+            if (x + 5 > area.minPoint().x && x - 5 < area.maxPoint().x)
+                throw std::logic_error("Circle placed over an area snapped into a grid line");
+        }
+    }
+
+    // The check of the results finds a circle entering an exclusion area far from the origin, and accepts one touching it
+    void checkAreaIntrusion() {
+        objects::Rectangle zone({ 1e5, 1e5 }, { 1e5 + 100, 1e5 + 100 });
+        objects::Rectangle area({ 1e5 + 50, 1e5 }, { 1e5 + 60, 1e5 + 100 });
+        std::vector<objects::Rectangle> areas{ area };
+        objects::Circles circles;
+        circles.push_back(objects::Circle(1, 5, 5));
+        objects::SceneView scene(zone, areas, circles);
+
+        double tolerance = 8 * 1e5 * std::numeric_limits<objects::Scalar>::epsilon();
+        objects::ResultData result;
+        result.circles.push_back({ circles[0], { 1e5 + 45, 1e5 + 50 } });
+        if (algo::countPlacementViolations(scene, result, tolerance) != 0)
+            throw std::logic_error("Circle touching an exclusion area is reported");
+        result.circles.clear();
+        result.circles.push_back({ circles[0], { 1e5 + 46, 1e5 + 50 } });
+        if (algo::countPlacementViolations(scene, result, tolerance) != 1)
+            throw std::logic_error("Circle entering an exclusion area is not reported");
+    }
+
+    void runChecks() {
+        checkSnappedArea();
+        checkAreaIntrusion();
+        std::cout << "checks passed\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    if (options.mode == BenchmarkMode::GRID_SCAN)
+        printMeasurements(benchmark::runGridScan(options.min_side, options.max_side, options.repeats, options.scene.seed), options.format);
+    else if (options.mode == BenchmarkMode::BATCH)
+        printMeasurements(runBatch(options), options.format);
+    else if (options.mode == BenchmarkMode::CHECKS)
+        runChecks();
+    else
+        printMeasurements(runScaling(options), options.format);
+    return 0;
+}